@@ -0,0 +1,60 @@
+// heap bytes per graph taken by GraphSet with node based sets and with flat tables.
+// Usage: bench_certset dir, where dir holds .gr files named like R(3,6;n,e,d).gr,
+// e.g. ../data/RAMSEY/R(3,6). All graphs on n vertices form one level
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <malloc.h>
+
+#include "Graph.h"
+
+// bytes in use on the heap
+size_t heap() {
+    return mallinfo2().uordblks;
+}
+
+// heap bytes taken by a set of all graphs on n vertices from the files
+size_t measure(size_t n, const std::vector<std::string>& files, bool flat, size_t& count) {
+    size_t before = heap();
+    GraphSet* graphs = new GraphSet(n, flat);
+    for (const std::string& path : files) {
+        GraphFile file(path, n);
+        for (size_t i = 0; i < file.count(); i++) {
+            graphs->insert(Graph(file[i]));
+        }
+    }
+    size_t bytes = heap() - before;
+    count = graphs->size();
+    delete graphs;
+    return bytes;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cout << "We expect a directory with .gr files" << std::endl;
+        return 1;
+    }
+    std::map<size_t, std::vector<std::string>> levels;
+    for (const auto& entry : std::filesystem::directory_iterator(argv[1])) {
+        std::string name = entry.path().filename().string();
+        size_t semicolon = name.find(';');
+        if (semicolon == std::string::npos || entry.path().extension() != ".gr") {
+            continue;
+        }
+        levels[std::atoi(name.c_str() + semicolon + 1)].push_back(entry.path().string());
+    }
+
+    std::cout << "n\tgraphs\tcert bytes\tnodes, B/graph\tflat, B/graph" << std::endl;
+    for (const auto& level : levels) {
+        size_t n = level.first;
+        size_t count;
+        size_t nodes = measure(n, level.second, false, count);
+        size_t flat = measure(n, level.second, true, count);
+        if (count == 0) {
+            continue;
+        }
+        std::cout << n << "\t" << count << "\t" << Graph::certSize(n) << "\t\t"
+                  << double(nodes) / count << "\t\t" << double(flat) / count << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+// compression of the sorted .gr files of a directory: the size against the plain
+// sorted file and the speed of decoding all blocks, in MB of certificates per second.
+// Usage: bench_compress dir, where dir holds .gr files named like R(3,6;n,e,d).gr
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "CompressedFile.h"
+#include "Graph.h"
+
+double seconds(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+    return time.count();
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cout << "We expect a directory with .gr files" << std::endl;
+        return 1;
+    }
+    size_t plain = 0;
+    size_t packed = 0;
+    size_t graphs = 0;
+    double time = 0;
+    const size_t rounds = 5;
+    for (const auto& entry : std::filesystem::directory_iterator(argv[1])) {
+        std::string name = entry.path().filename().string();
+        size_t semicolon = name.find(';');
+        if (semicolon == std::string::npos || entry.path().extension() != ".gr") {
+            continue;
+        }
+        size_t n = std::atoi(name.c_str() + semicolon + 1);
+        GraphFile file(entry.path().string(), n);
+        GraphSet set(n, true);
+        file.scan(0, file.count(), [&](size_t, const GraphView& V) {
+            set.insert(Graph(V));
+        });
+        set.writeSorted("bench_compress.gr");
+        compressGr("bench_compress.gr", "bench_compress.grz", n);
+        plain += std::filesystem::file_size("bench_compress.gr");
+        packed += std::filesystem::file_size("bench_compress.grz");
+
+        CompressedFile compressed("bench_compress.grz");
+        size_t sum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t r = 0; r < rounds; r++) {
+            compressed.scan([&](size_t, const uint8_t* cert) {
+                sum += cert[0];
+            });
+        }
+        time += seconds(start);
+        graphs += compressed.count();
+        std::cout << name << ": " << compressed.count() << " graphs, " << std::filesystem::file_size("bench_compress.gr")
+                  << " -> " << std::filesystem::file_size("bench_compress.grz") << " bytes (" << sum % 10 << ")" << std::endl;
+    }
+    std::remove("bench_compress.gr");
+    std::remove("bench_compress.grz");
+    std::cout << graphs << " graphs, " << plain << " -> " << packed << " bytes, ratio " << double(plain) / packed
+              << ", decoding " << plain * rounds / time / 1e6 << " MB/s, " << graphs * rounds / time / 1e6 << " M graphs/s" << std::endl;
+    return 0;
+}
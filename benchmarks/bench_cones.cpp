@@ -0,0 +1,103 @@
+// the cones of all parent graphs of a directory of .gr files, enumerated by ConeGenerator
+// and by a plain search checking every forbidden set containing the new candidate vertex
+// against the vertices chosen, as the generators did before.
+// Usage: bench_cones F dir, where F is Kn or Cn and dir holds .gr files named like R(3,6;n,e,d).gr.
+// The cones of a parent with minimum degree d have at most d + 1 vertices
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ConeGenerator.h"
+#include "Graph.h"
+#include "GraphView.h"
+#include "Matcher.h"
+
+double seconds(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+    return time.count();
+}
+
+// the number of cones of 1 to d vertices extending cone by vertices above its last one
+size_t plainCones(std::vector<size_t>& cone, size_t d, size_t n, const std::vector<std::vector<std::vector<size_t>>>& sets,
+                  std::vector<bool>& chosen) {
+    size_t count = 0;
+    for (size_t x = cone.empty() ? 0 : cone.back() + 1; x < n; x++) {
+        bool feasible = true;
+        for (size_t i = 0; i < sets[x].size() && feasible; i++) {
+            bool inside = true;
+            for (size_t y : sets[x][i]) {
+                inside = inside && (y == x || chosen[y]);
+            }
+            feasible = !inside;
+        }
+        if (!feasible) {
+            continue;
+        }
+        count++;
+        if (cone.size() + 1 < d) {
+            cone.push_back(x);
+            chosen[x] = true;
+            count += plainCones(cone, d, n, sets, chosen);
+            chosen[x] = false;
+            cone.pop_back();
+        }
+    }
+    return count;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3 || (argv[1][0] != 'K' && argv[1][0] != 'C')) {
+        std::cout << "We expect the forbidden graph Kn or Cn and a directory with .gr files" << std::endl;
+        return 1;
+    }
+    size_t m = std::atoi(argv[1] + 1);
+    SubgraphMatcher M(argv[1][0] == 'K' ? K(m) : C(m));
+
+    size_t graphs = 0;
+    size_t cones[2] = {0, 0};
+    double time[2] = {0, 0};
+    ConeGenerator cg;
+    for (const auto& entry : std::filesystem::directory_iterator(argv[2])) {
+        std::string name = entry.path().filename().string();
+        size_t semicolon = name.find(';');
+        if (semicolon == std::string::npos || entry.path().extension() != ".gr") {
+            continue;
+        }
+        size_t n = std::atoi(name.c_str() + semicolon + 1);
+        size_t d = std::atoi(name.c_str() + name.rfind(',') + 1) + 1;
+        GraphFile file(entry.path().string(), n);
+        file.scan(0, file.count(), [&](size_t, const GraphView& V) {
+            Graph H(V);
+            graphs++;
+            auto start = std::chrono::steady_clock::now();
+            cg.reset(H, M);
+            cg.visitCones(1, d, [&](const std::vector<size_t>&) {
+                cones[0]++;
+            });
+            time[0] += seconds(start);
+
+            start = std::chrono::steady_clock::now();
+            std::vector<std::vector<std::vector<size_t>>> sets(n);
+            bool blocked = false;
+            for (const std::vector<size_t>& S : M.forbiddenSets(H)) {
+                blocked = blocked || S.empty();
+                for (size_t x : S) {
+                    sets[x].push_back(S);
+                }
+            }
+            std::vector<size_t> cone;
+            std::vector<bool> chosen(n, false);
+            cones[1] += blocked ? 0 : plainCones(cone, d, n, sets, chosen);
+            time[1] += seconds(start);
+        });
+    }
+
+    const char* names[] = {"ConeGenerator", "plain search"};
+    for (int way = 0; way < 2; way++) {
+        std::cout << names[way] << ": " << graphs << " graphs, " << cones[way] << " cones, "
+                  << time[way] * 1000 << " ms, " << cones[way] / time[way] / 1e6 << " M cones/s" << std::endl;
+    }
+    return cones[0] == cones[1] ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+// speed and quality of hashBytes and compareCertificates on real certificates,
+// compared with the byte by byte versions used before.
+// Usage: bench_hash dir, where dir holds .gr files named like R(3,6;n,e,d).gr
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <unordered_set>
+
+#include "Graph.h"
+
+size_t oldHash(const uint8_t* data, size_t size) {
+    static const size_t p = 1000000009;
+    size_t h = 0;
+    for (size_t i = 0; i < size; ++i) {
+        h = h * p + data[i];
+    }
+    return h;
+}
+
+int oldCompare(const Certificate& C, const Certificate& D) {
+    if (C.size() != D.size()) {
+        return C.size() > D.size() ? -1 : 1;
+    }
+    size_t i = 0;
+    while (i < C.size() && C[i] == D[i]) {
+        i++;
+    }
+    if (i >= C.size()) {
+        return 0;
+    }
+    return C[i] > D[i] ? -1 : 1;
+}
+
+double seconds(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+    return time.count();
+}
+
+// full 64-bit collisions between distinct certificates and the fullest bucket
+// of a table of 2^bits buckets, taking the low bits and the top bits of the hashes
+void quality(const std::vector<Certificate>& certs, const std::vector<size_t>& hashes, const char* name) {
+    std::unordered_set<std::string> inputs;
+    std::unordered_set<size_t> distinct;
+    for (size_t i = 0; i < certs.size(); i++) {
+        // equal bytes of certificates of equal length are one input, e.g. the empty graphs on 2, 3 and 4 vertices
+        if (inputs.insert(std::string((const char*)certs[i].data(), certs[i].size())).second) {
+            distinct.insert(hashes[i]);
+        }
+    }
+    size_t bits = 1;
+    while ((size_t(2) << bits) <= hashes.size()) {
+        bits++;
+    }
+    std::vector<size_t> low(size_t(1) << bits);
+    std::vector<size_t> top(size_t(1) << bits);
+    for (size_t h : hashes) {
+        low[h & (low.size() - 1)]++;
+        top[h >> (64 - bits)]++;
+    }
+    std::cout << name << ": " << inputs.size() - distinct.size() << " collisions among " << inputs.size() << " inputs, fullest of 2^" << bits << " buckets: "
+              << *std::max_element(low.begin(), low.end()) << " by low bits, "
+              << *std::max_element(top.begin(), top.end()) << " by top bits" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cout << "We expect a directory with .gr files" << std::endl;
+        return 1;
+    }
+    std::vector<Certificate> certs;
+    for (const auto& entry : std::filesystem::directory_iterator(argv[1])) {
+        std::string name = entry.path().filename().string();
+        size_t semicolon = name.find(';');
+        if (semicolon == std::string::npos || entry.path().extension() != ".gr") {
+            continue;
+        }
+        size_t n = std::atoi(name.c_str() + semicolon + 1);
+        GraphFile file(entry.path().string(), n);
+        for (size_t i = 0; i < file.count(); i++) {
+            Certificate cert(Graph::certSize(n));
+            std::copy(file[i].data(), file[i].data() + cert.size(), cert.data());
+            certs.push_back(std::move(cert));
+        }
+    }
+    std::cout << certs.size() << " certificates" << std::endl;
+
+    const size_t rounds = 20;
+    std::vector<size_t> old_hashes(certs.size());
+    std::vector<size_t> new_hashes(certs.size());
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < certs.size(); i++) {
+            old_hashes[i] += oldHash(certs[i].data(), certs[i].size());
+        }
+    }
+    double old_time = seconds(start);
+    start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < certs.size(); i++) {
+            new_hashes[i] += hashBytes(certs[i].data(), certs[i].size());
+        }
+    }
+    double new_time = seconds(start);
+    std::cout << "hash, ns per certificate: " << old_time / rounds / certs.size() * 1e9 << " before, "
+              << new_time / rounds / certs.size() * 1e9 << " now" << std::endl;
+    for (size_t i = 0; i < certs.size(); i++) {
+        old_hashes[i] = oldHash(certs[i].data(), certs[i].size());
+        new_hashes[i] = hashBytes(certs[i].data(), certs[i].size());
+    }
+    quality(certs, old_hashes, "before");
+    quality(certs, new_hashes, "now");
+
+    // sorting compares neighbours with long common prefixes
+    std::vector<Certificate> a = certs;
+    std::vector<Certificate> b = certs;
+    start = std::chrono::steady_clock::now();
+    std::sort(a.begin(), a.end(), [](const Certificate& C, const Certificate& D) {
+        return oldCompare(C, D) < 0;
+    });
+    old_time = seconds(start);
+    start = std::chrono::steady_clock::now();
+    std::sort(b.begin(), b.end(), [](const Certificate& C, const Certificate& D) {
+        return compareCertificates(C, D) < 0;
+    });
+    new_time = seconds(start);
+    std::cout << "sort, s: " << old_time << " before, " << new_time << " now, "
+              << (a == b ? "same order" : "ORDER DIFFERS") << std::endl;
+    return 0;
+}
@@ -0,0 +1,84 @@
+// reading all graphs of a directory of .gr files with a stream, one certificate
+// per read as the generators did, and through a memory mapped GraphFile.
+// The read system calls are taken from /proc/self/io.
+// Usage: bench_reader dir, where dir holds .gr files named like R(3,6;n,e,d).gr
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "Graph.h"
+
+double seconds(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+    return time.count();
+}
+
+size_t readCalls() {
+    std::ifstream io("/proc/self/io");
+    std::string key;
+    size_t value;
+    while (io >> key >> value) {
+        if (key == "syscr:") {
+            return value;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cout << "We expect a directory with .gr files" << std::endl;
+        return 1;
+    }
+    std::vector<std::pair<std::string, size_t>> files;
+    for (const auto& entry : std::filesystem::directory_iterator(argv[1])) {
+        std::string name = entry.path().filename().string();
+        size_t semicolon = name.find(';');
+        if (semicolon == std::string::npos || entry.path().extension() != ".gr") {
+            continue;
+        }
+        files.emplace_back(entry.path().string(), std::atoi(name.c_str() + semicolon + 1));
+    }
+
+    const size_t rounds = 5;
+    for (int way = 0; way < 4; way++) {
+        size_t graphs = 0;
+        size_t edges = 0;
+        size_t calls = readCalls();
+        auto start = std::chrono::steady_clock::now();
+        for (size_t r = 0; r < rounds; r++) {
+            for (const auto& [path, n] : files) {
+                // the generators build a graph, filters may look at the certificate only
+                bool build = way < 2;
+                if (way % 2 == 0) {
+                    std::fstream stream;
+                    stream.open(path, std::ios::in | std::ios::binary);
+                    Certificate cert(Graph::certSize(n));
+                    for (;;) {
+                        Structure::readStruct(stream, cert);
+                        if (stream.eof()) {
+                            break;
+                        }
+                        graphs++;
+                        edges += build ? Graph(n, cert).edges() : GraphView(n, cert.data()).edges();
+                    }
+                } else {
+                    GraphFile file(path, n);
+                    file.scan(0, file.count(), [&](size_t, const GraphView& V) {
+                        graphs++;
+                        edges += build ? Graph(V).edges() : V.edges();
+                    });
+                }
+            }
+        }
+        double time = seconds(start);
+        calls = readCalls() - calls;
+        const char* names[] = {"stream + Graph", "GraphFile + Graph", "stream, certificate only", "GraphFile, view only"};
+        std::cout << names[way] << ": " << graphs / rounds << " graphs, " << edges / rounds << " edges, "
+                  << time / rounds * 1000 << " ms per pass, " << graphs / time / 1e6 << " M graphs/s, "
+                  << calls / rounds << " read calls per pass" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,125 @@
+// throughput of concurrent insertions into StructSet for 1 to 64 threads,
+// compared with one unordered_set behind a single mutex.
+// Usage: bench_structset [path n], where path is a .gr file of graphs on n vertices.
+// Without arguments random certificates of graphs on 20 vertices are used.
+// Every certificate is inserted twice, so half of the insertions find it present
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+
+#include "Graph.h"
+#include "MappedFile.h"
+
+// a structure given only by its certificate, enough for the sets
+class Key : public Structure {
+public:
+    Key(size_t n, const Certificate& cert) : Structure(n, cert) {
+    }
+
+protected:
+    int compareOrders(const Perm&, const Perm&, size_t, size_t) const override {
+        return 0;
+    }
+    size_t degsize() const override {
+        return 1;
+    }
+    int color(size_t, size_t) const override {
+        return 0;
+    }
+    Certificate getCertificate(const Perm&) const override {
+        return cert;
+    }
+};
+
+// the set all threads used before
+class LockedSet {
+public:
+    bool insertIfAbsent(const Structure& s) {
+        std::lock_guard<std::mutex> lock(mut_);
+        return data_.insert(s.certificate()).second;
+    }
+
+    size_t size() const {
+        return data_.size();
+    }
+
+private:
+    std::unordered_set<Certificate> data_;
+    std::mutex mut_;
+};
+
+// seconds spent by t threads inserting the keys, the thread th takes every t-th key
+template<class Set>
+double run(const std::vector<Key>& keys, size_t t, size_t& found) {
+    Set set;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t th = 0; th < t; th++) {
+        threads.emplace_back([&keys, &set, t, th] {
+            for (size_t i = th; i < keys.size(); i += t) {
+                set.insertIfAbsent(keys[i]);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+    found = set.size();
+    return time.count();
+}
+
+int main(int argc, char** argv) {
+    size_t n = 20;
+    std::vector<Certificate> certs;
+    if (argc == 3) {
+        n = std::atoi(argv[2]);
+        GraphFile file(argv[1], n);
+        if (!file.good()) {
+            std::cout << "Cannot read " << argv[1] << std::endl;
+            return 1;
+        }
+        size_t l = Graph::certSize(n);
+        for (size_t i = 0; i < file.count(); i++) {
+            Certificate cert(l);
+            std::copy(file[i].data(), file[i].data() + l, cert.data());
+            certs.push_back(std::move(cert));
+        }
+    } else {
+        std::mt19937_64 random(1);
+        size_t l = Graph::certSize(n);
+        for (size_t i = 0; i < (1 << 19); i++) {
+            Certificate cert(l);
+            for (size_t j = 0; j < l; j++) {
+                cert[j] = random();
+            }
+            certs.push_back(std::move(cert));
+        }
+    }
+
+    std::vector<Key> keys;
+    for (size_t r = 0; r < 2; r++) {
+        for (const Certificate& cert : certs) {
+            keys.emplace_back(n, cert);
+        }
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(2));
+
+    std::cout << keys.size() << " insertions of " << certs.size() << " certificates, "
+              << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+    std::cout << "threads  single mutex, Mops/s  StructSet, Mops/s" << std::endl;
+    for (size_t t = 1; t <= 64; t *= 2) {
+        size_t locked_size;
+        size_t sharded_size;
+        double locked = run<LockedSet>(keys, t, locked_size);
+        double sharded = run<StructSet>(keys, t, sharded_size);
+        if (locked_size != sharded_size) {
+            std::cout << "Sets differ: " << locked_size << " and " << sharded_size << std::endl;
+            return 1;
+        }
+        std::cout << t << "\t " << keys.size() / locked / 1e6 << "\t\t\t" << keys.size() / sharded / 1e6 << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,114 @@
+// set operations on .gr files of graphs on n vertices without loading them into memory.
+// The inputs of union, diff and common must be sorted, others are refused. The sort command sorts any .gr file:
+//   grtool n sort <in> <out>
+//   grtool n union <out> <in> ...
+//   grtool n diff <out> <a> <b>      the graphs of a which are not in b
+//   grtool n common <out> <a> <b>
+//   grtool n check <in>              tells whether the file is sorted and its checksum is right
+//   grtool n compress <in> <out>     writes a compressed file, see CompressedFile
+//   grtool n decompress <in> <out>
+//   grtool n merge <dir> <shard dir> ...
+//                                    every file of graphs on n vertices in the shard directories is
+//                                    merged with the files of the same name in the other shards and
+//                                    in dir into one sorted file in dir, without repeated graphs
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "CompressedFile.h"
+#include "Graph.h"
+#include "SortedFile.h"
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        std::cout << "We expect the number of vertices n, a command sort, union, diff, common, check, compress, decompress or merge and the files" << std::endl;
+        return 1;
+    }
+    size_t n = std::atoi(argv[1]);
+    std::string command = argv[2];
+    std::vector<std::string> files(argv + 3, argv + argc);
+    size_t length = Graph::certSize(n);
+    // false once a file can not be read or written
+    bool good = true;
+
+    if (command == "check" && files.size() == 1) {
+        CompressedFile compressed(files[0]);
+        if (compressed.good()) {
+            std::cout << compressed.count() << " graphs in " << compressed.blocks() << " blocks, "
+                      << (compressed.header().sorted ? "sorted" : "not sorted") << ", "
+                      << (compressed.verify() ? "checksum right" : "checksum wrong") << std::endl;
+            return compressed.verify() ? 0 : 1;
+        }
+        GraphFile file(files[0], n);
+        if (!file.good()) {
+            std::cout << files[0] << " is not a file of graphs on " << n << " vertices or is truncated" << std::endl;
+            return 1;
+        }
+        bool sorted = SortedFile(files[0], length).isSorted();
+        std::cout << file.count() << " graphs, " << (sorted ? "sorted" : "not sorted") << ", "
+                  << (file.verify() ? "checksum right" : "checksum wrong") << std::endl;
+        return file.verify() ? 0 : 1;
+    }
+    if (command == "sort" && files.size() == 2) {
+        if (!GraphFile(files[0], n).good()) {
+            std::cout << "Can not read " << files[0] << std::endl;
+            return 1;
+        }
+        std::cout << sortFile(files[0], files[1], n, &good) << std::endl;
+        return good ? 0 : 1;
+    }
+    if (command == "merge" && files.size() >= 2) {
+        std::vector<std::string> shards(files.begin() + 1, files.end());
+        size_t count = mergeShards(files[0], shards, n, &good);
+        if (!good) {
+            std::cout << "Could not merge the shards, the files merged so far hold " << count << " graphs" << std::endl;
+            return 1;
+        }
+        std::cout << count << std::endl;
+        return 0;
+    }
+    if (command == "compress" && files.size() == 2) {
+        size_t count = compressGr(files[0], files[1], n, &good);
+        if (!good) {
+            std::cout << "Can not read " << files[0] << " or write " << files[1] << std::endl;
+            return 1;
+        }
+        std::cout << count << std::endl;
+        return 0;
+    }
+    if (command == "decompress" && files.size() == 2) {
+        size_t count = decompressGr(files[0], files[1], &good);
+        if (!good) {
+            std::cout << "Can not read " << files[0] << " or write " << files[1] << std::endl;
+            return 1;
+        }
+        std::cout << count << std::endl;
+        return 0;
+    }
+    if (command == "union" && files.size() >= 2) {
+        std::vector<std::string> inputs(files.begin() + 1, files.end());
+        size_t count = mergeSorted(inputs, files[0], length, &good);
+        if (good) {
+            std::cout << count << std::endl;
+            return 0;
+        }
+    } else if (command == "diff" && files.size() == 3) {
+        size_t count = differenceSorted(files[1], files[2], files[0], length, &good);
+        if (good) {
+            std::cout << count << std::endl;
+            return 0;
+        }
+    } else if (command == "common" && files.size() == 3) {
+        size_t count = intersectSorted(files[1], files[2], files[0], length, &good);
+        if (good) {
+            std::cout << count << std::endl;
+            return 0;
+        }
+    }
+    if (!good) {
+        std::cout << "An input can not be read or is not sorted, see the sort command, or the output can not be written" << std::endl;
+        return 1;
+    }
+    std::cout << "Wrong command or number of files" << std::endl;
+    return 1;
+}
@@ -1,182 +1,265 @@
 // build and write to the disk all Ramsey R(G,k) graphs 
 // by the one-vertex extension algorithm.
-// Here we assume that G is K_3, K_4, C_4 or C_5 only.
+// Here G is any small graph: Kn, Cn, Pn, Wn, Ka,b or Kn-e.
+// With the option --canonical the graphs are not collected into a common set:
+// every extension is kept iff it passes the canonical augmentation test.
+// With the option --budget=M the sets of graphs of the files of a level take about M megabytes
+// of memory together, the rest is spilled to the disk and merged when the files are written
+// With the option --sync every file is flushed to the disk by fsync before it gets its name
+// With the option --checkpoint=M the state of the level being built is saved every M minutes:
+// the sets of the output files go to their run files and the positions reached in the parent
+// files to a .checkpoint file. A run started again resumes the level from its checkpoint
+// With the option --shard=r/m the run is the shard r of m independent processes, possibly on
+// several machines, which share the parent graphs of one level: the i-th parent graph, counted
+// over all parent files, is extended by the shard i mod m. The shard builds the first level
+// which is not in the directory of R(G,k), writes its part to the subdirectory shard<r>-<m>
+// and stops. The parts are merged by grtool n merge <dir> <dir>/shard0-<m> ..., then the
+// shards are run again for the next level, till a level has no graphs
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
 #include <iostream>
+#include <numeric>
+#include <set>
 #include <sstream>
 #include <string>
-#include <thread>
 #include <sys/stat.h>
+#include <unistd.h>
 
+#include "Checkpoint.h"
+#include "ConeGenerator.h"
+#include "ExternalGraphSet.h"
 #include "Graph.h"
-
-const std::vector<std::string> names = {"K3", "K4", "C3", "C4", "C5", "3", "4"};
+#include "GraphView.h"
+#include "Matcher.h"
+#include "Pipeline.h"
+#include "TaskPool.h"
 
 int num_threads = 8;
-
-// class generating all feasible cones for the one-vertex extension
-class ConeGenerator {
-public:
-    ConeGenerator(const Graph& H) : H(H), n(H.size()) {
+// this process is the shard of that number out of shards
+size_t shard = 0;
+size_t shards = 1;
+// the parent files loaded ahead by the reader and the files extended at once
+const size_t read_ahead = 2;
+const size_t window = 4;
+// the bytes of the parent files read and the searches of cones done
+std::atomic<size_t> bytes_read(0);
+std::atomic<size_t> searches(0);
+
+// the graphs of one output file
+struct Target {
+    Target(size_t n, size_t budget, bool sync, const std::string& path, size_t workers) : path(path), length(Graph::certSize(n)),
+        graphs(n, budget, path, sync), found(workers), saved(0) {
+    }
+    ~Target() {
+        std::remove((path + ".found").c_str());
     }
 
-    std::vector<std::vector<size_t>> getConesK3(size_t deg) {
-        d = deg;
-        cones.clear();
-        cone.assign(d, 0);
-        if (d == 0) {
-            return cones;
+    size_t size() const {
+        size_t count = graphs.size() + saved;
+        for (const std::vector<Certificate>& certs : found) {
+            count += certs.size();
         }
+        return count;
+    }
 
-        F = H;		
-        for (size_t i = 0; i + d <= n; i++) {
-            cone[0] = i;
-            next3(1);
+    // keeps the set on the disk for a checkpoint, the graphs found in the canonical mode
+    // are appended to the file path.found. Sets first and runs to the first run file of the
+    // set and their number, returns false if a file could not be written
+    bool save(size_t& first, size_t& runs) {
+        // a file left by a run which ended before its first checkpoint is written again
+        GrWriter writer(path + ".found", length, saved > 0);
+        size_t count = 0;
+        for (const std::vector<Certificate>& certs : found) {
+            for (const Certificate& cert : certs) {
+                writer.add(cert.data());
+            }
+            count += certs.size();
         }
-        return std::move(cones);
+        writer.close();
+        if (!writer.good()) {
+            // the graphs stay in memory, a part of them appended is cut off
+            truncate((path + ".found").c_str(), saved * length);
+            return false;
+        }
+        for (std::vector<Certificate>& certs : found) {
+            certs.clear();
+        }
+        saved += count;
+        runs = graphs.checkpoint(first);
+        return graphs.good();
     }
 
-    std::vector<std::vector<size_t>> getConesK4(size_t deg) {
-        d = deg;
-        cones.clear();
-        cone.assign(d, 0);
-        if (d == 0) {
-            return cones;
-        }
+    // the checkpoint is on the disk, the run files merged away are removed
+    void committed() {
+        graphs.committed();
+    }
 
-        F = H;		
-        for (size_t i = 0; i + d <= n; i++) {
-            cone[0] = i;
-            next4(1);
-        }
-        return std::move(cones);
+    // takes the state saved by a run which did not finish, the graphs appended to
+    // path.found after its checkpoint are cut off
+    bool restore(size_t first, size_t runs, size_t count) {
+        saved = count;
+        return graphs.restore(first, runs) && (count == 0 || truncate((path + ".found").c_str(), count * length) == 0);
     }
 
-    std::vector<std::vector<size_t>> getConesC4(size_t deg) {
-        d = deg;
-        cones.clear();
-        cone.assign(d, 0);
-        if (d == 0) {
-            return cones;
+    // forgets all graphs
+    void reset() {
+        graphs.clear();
+        for (std::vector<Certificate>& certs : found) {
+            certs.clear();
         }
+        saved = 0;
+        std::remove((path + ".found").c_str());
+    }
 
-        F.resize(H.size());
-
-        for (size_t i = 0; i < n; i++) {
-            for (size_t j = i + 1; j < n; j++) {
-                for (size_t k = 0; k < n; k++) {
-                    if (H.edge(i, k) && H.edge(k, j)) {
-                        F.addEdge(i, j);
-                    }
-                }
-            }
+    // the graphs found in the canonical mode, the saved ones first
+    void visitFound(const std::function<void(const uint8_t*)>& visit) const {
+        MappedFile file(path + ".found");
+        for (size_t i = 0; i < saved && file.size() >= saved * length; i++) {
+            visit(file.data() + i * length);
         }
-		
-        for (size_t i = 0; i + d <= n; i++) {
-            cone[0] = i;
-            next3(1);
+        for (const std::vector<Certificate>& certs : found) {
+            for (const Certificate& cert : certs) {
+                visit(cert.data());
+            }
         }
-        return std::move(cones);
     }
 
-    std::vector<std::vector<size_t>> getConesC5(size_t deg) {
-        d = deg;
-        cones.clear();
-        cone.assign(d, 0);
-        if (d == 0) {
-            return cones;
-        }
+    std::string path;
+    size_t length;
+    ExternalGraphSet graphs;
+    // graphs found by every worker in the canonical mode
+    std::vector<std::vector<Certificate>> found;
+    // graphs found in the canonical mode and saved in path.found
+    size_t saved;
+};
 
-        F.resize(H.size());
-        // looking for path i -- k -- l -- j
-        for (size_t i = 0; i < n; i++) {
-            for (size_t j = i + 1; j < n; j++) {
-                for (size_t k = 0; k < n; k++) {
-                    if (!H.edge(i, k) || k == j) {
-                        continue;
-                    }
-                    for (size_t l = 0; l < n; l++) {
-                        if (H.edge(k, l) && H.edge(l, j) && l != i) {
-                            F.addEdge(i, j);
-                        }
-                    }
-                }
-            }
+// the forbidden graph given by its name: Kn, Cn, Pn, Wn (a wheel with n spokes),
+// Ka,b or Kn-e. Returns false if the name is not recognized
+bool getGraph(const std::string& name, Graph& G) {
+    if (name.size() < 2 || name.find_first_not_of("KCPW0123456789,-e") != std::string::npos) {
+        return false;
+    }
+    std::string s = name.substr(1);
+    bool minus_edge = false;
+    if (name[0] == 'K' && s.size() > 2 && s.substr(s.size() - 2) == "-e") {
+        minus_edge = true;
+        s = s.substr(0, s.size() - 2);
+    }
+    size_t comma = s.find(',');
+    if (name[0] == 'K' && comma != std::string::npos && !minus_edge) {
+        size_t a = std::atoi(s.substr(0, comma).c_str());
+        size_t b = std::atoi(s.substr(comma + 1).c_str());
+        if (a == 0 || b == 0) {
+            return false;
         }
-		
-        for (size_t i = 0; i + d <= n; i++) {
-            cone[0] = i;
-            next3(1);
+        G = K(a, b);
+        return true;
+    }
+    if (s.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    size_t m = std::atoi(s.c_str());
+    if (name[0] == 'K' && m >= 2) {
+        G = K(m);
+        if (minus_edge) {
+            G.killEdge(0, 1);
         }
-        return std::move(cones);
+    } else if (name[0] == 'C' && m >= 3 && !minus_edge) {
+        G = C(m);
+    } else if (name[0] == 'P' && m >= 2 && !minus_edge) {
+        G = P(m);
+    } else if (name[0] == 'W' && m >= 3 && !minus_edge) {
+        G = W(m);
+    } else {
+        return false;
     }
+    return true;
+}
 
-private:
-    void next3(size_t l) {
-        if (l == d) {
-            cones.push_back(cone);
-            return;
+// are there two cones of d vertices with equal multisets of vertex colors, which is necessary
+// for them to be in one orbit of Aut(H). The cones lie one after the other in a flat buffer.
+// A multiset is hashed by a sum over its colors, so a collision only costs the computation of Aut(H)
+bool similarCones(const std::vector<size_t>& cones, size_t d, const std::vector<size_t>& colors, std::vector<uint64_t>& keys) {
+    keys.clear();
+    for (size_t i = 0; i < cones.size(); i += d) {
+        uint64_t key = 0;
+        for (size_t j = i; j < i + d; j++) {
+            uint64_t c = colors[cones[j]] + 1;
+            key += (c * 0xBF58476D1CE4E5B9ull) ^ (c >> 3) * 0x94D049BB133111EBull;
         }
+        keys.push_back(key);
+    }
+    std::sort(keys.begin(), keys.end());
+    return std::adjacent_find(keys.begin(), keys.end()) != keys.end();
+}
 
-        for (size_t i = cone[l - 1] + 1; i + d <= n + l; i++) {
-            bool B = true;	
-            // trianglefree check		
-            for (size_t j = 0; j < l; j++ ) {
-                if (F.edge(i, cone[j])) {
-                    B = false;
-                    break;
-                }
-            }
-
-            if (!B) {
-                continue;
-            }
-
-            cone[l] = i;
-            next3(l + 1);
+// keeps the cones of d vertices lying in distinct orbits of the group A, which must preserve
+// the set of all cones. The cones are listed in lexicographic order, so the first cone met
+// in every orbit is its minimal image
+void orbitRepresentatives(std::vector<size_t>& cones, size_t d, const Group& A) {
+    if (A.order() == 1) {
+        return;
+    }
+    std::set<std::vector<size_t>> seen;
+    std::vector<size_t> cone(d);
+    size_t reps = 0;
+    for (size_t i = 0; i < cones.size(); i += d) {
+        std::copy(cones.begin() + i, cones.begin() + i + d, cone.begin());
+        if (seen.count(cone)) {
+            continue;
+        }
+        std::copy(cone.begin(), cone.end(), cones.begin() + reps);
+        reps += d;
+        for (std::vector<size_t>& image : A.orbit(cone)) {
+            seen.insert(std::move(image));
         }
     }
+    cones.resize(reps);
+}
 
-    void next4(size_t l) {
-        if (l == d) {
-            cones.push_back(cone);
-            return;
+// vertices of G of degree d
+std::vector<size_t> verticesOfDegree(const Graph& G, size_t d) {
+    std::vector<size_t> vertices;
+    for (size_t i = 0; i < G.size(); i++) {
+        if (G.degree(i) == d) {
+            vertices.push_back(i);
         }
+    }
+    return vertices;
+}
 
-        for (size_t i = cone[l - 1] + 1; i + d <= n + l; i++) {
-            bool B = true;	
-            // K4-free check		
-            for (size_t j = 0; j < l; j++ ) {
-                for (size_t k = j + 1; k < l; ++k) {
-                    if (F.edge(i, cone[j]) && F.edge(i, cone[k]) && F.edge(cone[j], cone[k])) {
-                        B = false;
-                        break;
-                    }
-                }
-                if (!B) {
-                    break;
-                }
-            }
-
-            if (!B) {
-                continue;
+int main(int argc, char** argv) {
+    bool canonical = false;
+    size_t budget = 0;
+    bool sync = false;
+    double checkpoint_minutes = 0;
+    while (argc > 1 && std::string(argv[argc - 1]).substr(0, 2) == "--") {
+        std::string option = argv[argc - 1];
+        if (option == "--canonical") {
+            canonical = true;
+        } else if (option.substr(0, 9) == "--budget=") {
+            budget = std::stoull(option.substr(9)) << 20;
+        } else if (option == "--sync") {
+            sync = true;
+        } else if (option.substr(0, 13) == "--checkpoint=") {
+            checkpoint_minutes = std::stod(option.substr(13));
+        } else if (option.substr(0, 8) == "--shard=" && option.find('/') != std::string::npos) {
+            shard = std::stoull(option.substr(8));
+            shards = std::stoull(option.substr(option.find('/') + 1));
+            if (shards == 0 || shard >= shards) {
+                std::cout << "We expect the shard r/m with 0 <= r < m" << std::endl;
+                return 1;
             }
-
-            cone[l] = i;
-            next4(l + 1);
+        } else {
+            std::cout << "Unknown option " << option << std::endl;
+            return 1;
         }
+        argc--;
     }
-
-    const Graph& H;
-    size_t d;
-    size_t n;
-    std::vector<size_t> cone;
-    std::vector<std::vector<size_t>> cones;
-    Graph F;
-};
-
-
-int main(int argc, char** argv) {
     if (argc != 3 && argc != 4) {
         std::cout << "Wrong number of arguments. We expect graph name G and positive integer k to compute the set R(G, k)" << std::endl;
         return 1;
@@ -188,11 +271,21 @@ int main(int argc, char** argv) {
         num_threads = std::atoi(argv[3]);
     }
 
-    if (std::find(names.begin(), names.end(), graph_name) == names.end()) {
-        std::cout << "Wrong graph name. We expect G to be K3, K4, C4 or C5" << std::endl;
+    if (graph_name == "3" || graph_name == "4") {
+        graph_name = "K" + graph_name;
+    }
+    if (graph_name == "C3") {
+        graph_name = "K3";
+    }
+    Graph F;
+    if (!getGraph(graph_name, F)) {
+        std::cout << "Wrong graph name. We expect G to be Kn, Cn, Pn, Wn, Ka,b or Kn-e" << std::endl;
         return 1;       
     }
-    if (graph_name == "K3" || graph_name == "C3") {
+    const SubgraphMatcher matcher(F);
+    const bool F_isolated = F.deg() == 0;
+    // data of K3 and K4 is kept under the names 3 and 4
+    if (graph_name == "K3") {
         graph_name = "3";
     }
     if (graph_name == "K4") {
@@ -203,12 +296,21 @@ int main(int argc, char** argv) {
     mkdir("../data/RAMSEY/", S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
     const std::string address = "../data/RAMSEY/R(" + graph_name + "," + std::to_string(k) + ")/";
     mkdir(address.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
-
-    // we start by writing the only Ramsey graph on 1 vertex to the corresponding file
+    // the graphs found by a shard go to its own directory
+    const std::string shard_address = shards > 1 ? address + "shard" + std::to_string(shard) + "-" + std::to_string(shards) + "/" : address;
+    mkdir(shard_address.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+
+    // the files are written in the background while the next ones are built
+    AsyncWriter output(sync);
+    CheckpointClock clock(checkpoint_minutes * 60);
+    // we start by writing the only Ramsey graph on 1 vertex to the corresponding file.
+    // Only the shard 0 writes it, the only one which extends that graph
     GraphSet one(1);
     one.insert(Graph(1).certify());
     std::string filename = address + "R(" + graph_name + "," + std::to_string(k) +";1,0,0).gr";
-    one.write(filename);
+    if (shard == 0) {
+        one.write(output, filename);
+    }
 
     // count of all R(G, n)-graphs
     size_t all = 1;
@@ -219,116 +321,407 @@ int main(int argc, char** argv) {
     // counts of all R(G, n)-graphs by number of vertices and edges
     std::vector<std::vector<size_t>> qve = { {}, {1} };
 	
+    TaskPool pool(num_threads);
+    auto start = std::chrono::steady_clock::now();
+
     // proceed to construct larger Ramsey graphs from smaller ones
     for (int n = 2;; n++) {
-        size_t q = 0;
-        std::vector<size_t> ve;
-        for (int e = 0; e <= n * (n - 1) / 2; e++) {
-            size_t qed = 0;
-            for (int d = 0; d <= n && d <= e; d++) {
-                std::string path = address + "R(" + graph_name + "," + std::to_string(k) + ";" + std::to_string(n) 
-                                 + "," + std::to_string(e) + "," + std::to_string(d) + ").gr";
-                std::ifstream file;
-                file.open(path, std::ios::in | std::ios::binary);
-                if (file.good()) {                    
-                    file.seekg(0, std::ios_base::end);
-                    size_t size = file.tellg() / Graph::certSize(n);
-                    while (qe.size() <= e) {
-                        qe.push_back(0);
-                    }
-
-                    qe[e] += size;
-                    qed += size;
-                    continue;
+        // the graphs on n - 1 vertices are read from their files
+        if (!output.wait()) {
+            std::cout << "Could not write the graphs on " << n - 1 << " vertices" << std::endl;
+            return 1;
+        }
+        const int E = n * (n - 1) / 2;
+        auto name = [&](int m, int e, int d) {
+            return address + "R(" + graph_name + "," + std::to_string(k) + ";" + std::to_string(m)
+                   + "," + std::to_string(e) + "," + std::to_string(d) + ").gr";
+        };
+        // the graphs on n vertices with e edges and minimum degree d. A file done before
+        // is counted by its header, a damaged one is built again
+        std::vector<std::vector<size_t>> counts(E + 1, std::vector<size_t>(n, 0));
+        std::vector<std::vector<std::unique_ptr<Target>>> targets(E + 1);
+        bool merged = false;
+        for (int e = 0; e <= E; e++) {
+            targets[e].resize(n);
+            for (int d = 0; d < n && d <= e; d++) {
+                const GraphFile done(name(n, e, d), n);
+                if (done.good()) {
+                    counts[e][d] = done.count();
+                    merged = true;
                 }
+            }
+        }
+        // a shard takes a level with some files as merged from all shards
+        const bool build = shards == 1 || !merged;
+        auto target_name = [&](int e, int d) {
+            return shard_address + name(n, e, d).substr(address.size());
+        };
+        // the checkpoint of the level left by a run which did not finish it. Its targets are built
+        // again even if their files are there, which happens if the run ended while writing them
+        Checkpoint checkpoint(shard_address + "R(" + graph_name + "," + std::to_string(k) + ";" + std::to_string(n) + ").checkpoint");
+        if (!build) {
+            checkpoint.clear();
+        }
+        // the lines of a damaged checkpoint are not used at all
+        bool valid = true;
+        for (const std::vector<size_t>& t : checkpoint.get("target")) {
+            valid = valid && t.size() == 5 && t[0] <= size_t(E) && t[1] < size_t(n);
+        }
+        for (const std::vector<size_t>& p : checkpoint.get("parent")) {
+            valid = valid && p.size() == 3;
+        }
+        if (!valid) {
+            std::cout << "The checkpoint " << checkpoint.path() << " is damaged, the graphs on " << n
+                      << " vertices are built from the start" << std::endl;
+            checkpoint.clear();
+        }
+        for (const std::vector<size_t>& t : checkpoint.get("target")) {
+            counts[t[0]][t[1]] = 0;
+        }
 
-                GraphSet graphs(n);
-                for (int dd = std::max(d - 1, 0); dd <= n - 1; dd++) {
-                    std::string filename = address + "R(" + graph_name + "," + std::to_string(k) + ";" +
-                                           std::to_string(n - 1) + "," + std::to_string(e - d) + "," + std::to_string(dd) + ").gr";
-                    std::fstream stream;
-                    stream.open(filename, std::ios::in | std::ios::binary);
-                    size_t graph_size = Graph::certSize(n - 1);
-                    size_t block_size;
-                    size_t file_size;
-                    if (!stream.good()) {
-                        continue;
-                    } else {
-                        stream.seekg(0, std::ios_base::end);
-                        file_size = stream.tellg();
-                        block_size = file_size / graph_size / num_threads + 1;
-                        block_size *= graph_size;
-                        stream.close();
+        // the targets of a level are filled at once, so they share the budget
+        size_t live = 0;
+        for (int e = 0; build && e <= (n - 1) * (n - 2) / 2; e++) {
+            for (int d = 0; d < n; d++) {
+                live += counts[e + d][d] == 0;
+            }
+        }
+        const size_t share = budget ? std::max<size_t>(1, budget / std::max<size_t>(1, live)) : 0;
+
+        // every parent file is read once: a graph H on n - 1 vertices with minimum degree dd and e edges
+        // gives the graphs on n vertices with e + d edges and minimum degree d <= dd + 1, all in one pass
+        std::vector<std::string> parents;
+        std::vector<std::vector<Target*>> parent_targets;
+        for (int e = 0; build && e <= (n - 1) * (n - 2) / 2; e++) {
+            for (int dd = 0; dd < n - 1; dd++) {
+                // the targets of the parents, those done before are skipped
+                std::vector<Target*> wanted(n, nullptr);
+                bool any = false;
+                for (int d = 0; d <= dd + 1 && d < n; d++) {
+                    if (counts[e + d][d] == 0) {
+                        if (!targets[e + d][d]) {
+                            targets[e + d][d].reset(new Target(n, share, sync, target_name(e + d, d), pool.size()));
+                        }
+                        wanted[d] = targets[e + d][d].get();
+                        any = true;
                     }
+                }
+                if (any) {
+                    parents.push_back(name(n - 1, e, dd));
+                    parent_targets.push_back(std::move(wanted));
+                }
+            }
+        }
 
-                    std::vector<std::thread> threads;
-                    for (int th = 0; th < num_threads; ++th) {
-                        threads.emplace_back([n, k, d, th, block_size, graph_size, file_size, &graph_name, &filename, &graphs]{
-                        Graph H(n - 1);
-                        std::fstream stream;
-                        stream.open(filename, std::ios::in | std::ios::binary);
-                        if (th * block_size >= file_size) {
-                            return;
+        // the graphs of a parent file before its position are done, sizes are the numbers of graphs
+        std::vector<size_t> position(parents.size(), 0);
+        std::vector<size_t> sizes(parents.size(), 0);
+        if (!checkpoint.empty()) {
+            bool restored = true;
+            for (const std::vector<size_t>& t : checkpoint.get("target")) {
+                Target* target = targets[t[0]][t[1]].get();
+                restored = restored && target && target->restore(t[2], t[3], t[4]);
+            }
+            for (const std::vector<size_t>& p : checkpoint.get("parent")) {
+                restored = restored && p[0] < parents.size() && p[1] <= p[2];
+                if (restored) {
+                    position[p[0]] = p[1];
+                    sizes[p[0]] = p[2];
+                }
+            }
+            if (restored) {
+                std::cout << "The graphs on " << n << " vertices are resumed from " << checkpoint.path() << std::endl;
+            } else {
+                std::cout << "The checkpoint " << checkpoint.path() << " is damaged, the graphs on " << n
+                          << " vertices are built from the start" << std::endl;
+                for (auto& row : targets) {
+                    for (auto& target : row) {
+                        if (target) {
+                            target->reset();
                         }
+                    }
+                }
+                std::fill(position.begin(), position.end(), 0);
+                std::fill(sizes.begin(), sizes.end(), 0);
+            }
+        }
+        // the sets are kept till the files are written, so that a checkpoint stays valid
+        const bool resumable = clock.enabled() || !checkpoint.empty();
+        // the files done before the checkpoint are not read again
+        std::vector<size_t> todo;
+        std::vector<std::string> todo_paths;
+        for (size_t j = 0; j < parents.size(); j++) {
+            if (position[j] == 0 || position[j] < sizes[j]) {
+                todo.push_back(j);
+                todo_paths.push_back(parents[j]);
+            }
+        }
 
-                        stream.seekg(th * block_size);
-                        for (int gr = 0; gr < block_size; gr += graph_size) {
-                            if (!readGraph(stream, H)) {
+        // the parent files flow through a pipeline: the reader loads the next files while
+        // the workers extend the graphs of the window of files open before, and the sets
+        // are written in the background. A file is closed when its group is done
+        ReadAhead reader(todo_paths, n - 1, read_ahead);
+        std::vector<std::unique_ptr<const GraphFile>> inputs(parents.size());
+        std::vector<std::unique_ptr<ChunkCursor>> cursors(parents.size());
+        std::vector<std::unique_ptr<TaskPool::Group>> groups(parents.size());
+        // the workers extend the graphs of the file j from its position on
+        auto dispatch = [&](size_t j) {
+            const GraphFile& input = *inputs[j];
+            const std::vector<Target*>& wanted = parent_targets[j];
+            // the number of parent graphs in the files before, which splits them among the shards
+            const size_t base = std::accumulate(sizes.begin(), sizes.begin() + j, size_t(0));
+            const size_t from = position[j];
+            // the graphs differ a lot in the number of their cones, so the workers take small chunks
+            cursors[j].reset(new ChunkCursor(input.count() - from, pool.size()));
+            ChunkCursor& cursor = *cursors[j];
+            groups[j].reset(new TaskPool::Group(pool));
+
+            for (size_t t = 0; t < pool.size() && t < input.count() - from; ++t) {
+                groups[j]->run([n, k, base, from, &wanted, F_isolated, canonical, &pool, &clock, &matcher, &input, &cursor]{
+                    const size_t th = pool.worker();
+                    // the new vertex n - 1 has the minimum degree d, so the canonical
+                    // augmentation chooses among the vertices of degree d
+                    auto keep = [n, th, canonical](Graph& G, size_t d, Target& target) {
+                        G.certify();
+                        if (!canonical) {
+                            target.graphs.insert(G);
+                        } else if (G.isCanonicalAugmentation(n - 1, verticesOfDegree(G, d))) {
+                            target.found[th].push_back(G.certificate());
+                        }
+                    };
+                    size_t min_deg = 0;
+                    size_t max_deg = 0;
+                    for (size_t d = 1; d < wanted.size(); d++) {
+                        if (wanted[d]) {
+                            min_deg = min_deg ? min_deg : d;
+                            max_deg = d;
+                        }
+                    }
+                    // the buffers of a worker live as long as the worker: the cones of d vertices
+                    // of a parent lie one after the other in cones[d]
+                    ConeGenerator cg;
+                    std::vector<std::vector<size_t>> cones(max_deg + 1);
+                    std::vector<uint64_t> keys;
+                    size_t first, last;
+                    while (!clock.due() && cursor.next(first, last)) {
+                        input.scan(from + first, from + last, [&](size_t i, const GraphView& V) {
+                            if ((base + i) % shards != shard) {
                                 return;
                             }
+                            Graph H(V);
                             Graph G = H + 1;
-                            if (d > 0) {
-                                ConeGenerator cg(H);
-                                std::vector<std::vector<size_t>> cones;
-                                if (graph_name == "C4") {
-                                    cones = cg.getConesC4(d);
-                                } else if (graph_name == "C5") {
-                                    cones = cg.getConesC5(d);
-                                } else if (graph_name == "4") {
-                                    cones = cg.getConesK4(d);
-                                } else {
-                                    cones = cg.getConesK3(d);
+                            // the new vertex may be isolated, which matters only if the forbidden graph has an isolated vertex
+                            bool isolated = wanted[0] && !G.hasIndependentSetThrough(n - 1, k);
+                            if (max_deg == 0) {
+                                if (isolated && (!F_isolated || ConeGenerator(H, matcher).isolated())) {
+                                    keep(G, 0, *wanted[0]);
                                 }
-                                for (const auto &cone : cones) {
-                                    for (size_t j = 0; j < d; j++) {
-                                        G.addEdge(cone[j], n - 1);
-                                    }
-                                    if (G.deg() == d) {
-                                        if (!G.subClique(k)) {
-                                            graphs.insert(G.certify());
-                                        }
+                                return;
+                            }
+
+                            cg.reset(H, matcher);
+                            searches++;
+                            if (isolated && (!F_isolated || cg.isolated())) {
+                                keep(G, 0, *wanted[0]);
+                            }
+                            // cones in one orbit of Aut(H) give isomorphic graphs. If the color refinement
+                            // separates all vertices of H, Aut(H) is trivial and every cone is kept at once.
+                            // Otherwise the cones are collected for the orbit reduction
+                            const std::vector<size_t> colors = H.colorClasses();
+                            const bool rigid = *std::max_element(colors.begin(), colors.end()) + 1 == H.size();
+                            for (auto& c : cones) {
+                                c.clear();
+                            }
+                            cg.visitCones(min_deg, max_deg, [&](const std::vector<size_t>& cone) {
+                                size_t d = cone.size();
+                                if (!wanted[d]) {
+                                    return;
+                                }
+                                for (size_t x : cone) {
+                                    G.addEdge(x, n - 1);
+                                }
+                                if (G.deg() == d && !G.hasIndependentSetThrough(n - 1, k)) {
+                                    if (rigid) {
+                                        keep(G, d, *wanted[d]);
+                                    } else {
+                                        cones[d].insert(cones[d].end(), cone.begin(), cone.end());
                                     }
-                                    for (size_t j = 0; j < d; j++) {
-                                        G.killEdge(cone[j], n - 1);
+                                }
+                                for (size_t x : cone) {
+                                    G.killEdge(x, n - 1);
+                                }
+                            });
+                            // Aut(H) costs a certification, so it is computed once and only if two cones have equal colors
+                            std::unique_ptr<Group> aut;
+                            for (size_t d = 1; d <= max_deg; d++) {
+                                if (cones[d].size() > d && similarCones(cones[d], d, colors, keys)) {
+                                    if (!aut) {
+                                        aut.reset(new Group(H.aut()));
                                     }
+                                    orbitRepresentatives(cones[d], d, *aut);
                                 }
-                            } else {
-                                if (G.subClique(k)) {
-                                    continue;
+                                for (size_t i = 0; i < cones[d].size(); i += d) {
+                                    for (size_t j = i; j < i + d; j++) {
+                                        G.addEdge(cones[d][j], n - 1);
+                                    }
+                                    keep(G, d, *wanted[d]);
+                                    for (size_t j = i; j < i + d; j++) {
+                                        G.killEdge(cones[d][j], n - 1);
+                                    }
                                 }
-
-                                graphs.insert(G.certify());
                             }
+                        });
+                    }
+                });
+            }
+        };
+        // the workers have stopped taking chunks: waits for the chunks taken, saves the sets
+        // and the positions in the parent files and lets the workers go on.
+        // Returns false if a set could not be saved, the checkpoint is not written then
+        auto save = [&]() {
+            for (size_t j = 0; j < parents.size(); j++) {
+                if (groups[j]) {
+                    groups[j]->wait();
+                    position[j] += cursors[j]->position();
+                    groups[j].reset();
+                }
+            }
+            checkpoint.clear();
+            for (size_t j = 0; j < parents.size(); j++) {
+                if (position[j]) {
+                    checkpoint.add("parent", {j, position[j], sizes[j]});
+                }
+            }
+            for (int e = 0; e <= E; e++) {
+                for (int d = 0; d < n && d <= e; d++) {
+                    if (targets[e][d]) {
+                        size_t first = 0;
+                        size_t runs = 0;
+                        if (!targets[e][d]->save(first, runs)) {
+                            return false;
                         }
+                        checkpoint.add("target", {size_t(e), size_t(d), first, runs, targets[e][d]->saved});
+                    }
+                }
+            }
+            checkpoint.write(output);
+            // the old checkpoint names the runs merged away, they are removed once the new one is written
+            if (!output.wait()) {
+                return false;
+            }
+            for (auto& row : targets) {
+                for (auto& target : row) {
+                    if (target) {
+                        target->committed();
+                    }
+                }
+            }
+            clock.restart();
+            for (size_t j = 0; j < parents.size(); j++) {
+                if (inputs[j] && position[j] < sizes[j]) {
+                    dispatch(j);
+                }
+            }
+            return true;
+        };
+        // waits till the graphs of the file j are extended, saving the checkpoints due meanwhile.
+        // Returns false if a checkpoint could not be saved
+        auto finish = [&](size_t j) {
+            while (groups[j]) {
+                groups[j]->wait();
+                if (clock.paused()) {
+                    if (!save()) {
+                        return false;
+                    }
+                } else {
+                    position[j] = sizes[j];
+                    groups[j].reset();
+                }
+            }
+            inputs[j].reset();
+            return true;
+        };
+
+        for (size_t i = 0; i < todo.size(); i++) {
+            if (i >= window && !finish(todo[i - window])) {
+                std::cout << "Could not save the checkpoint " << checkpoint.path() << std::endl;
+                return 1;
+            }
+            const size_t j = todo[i];
+            inputs[j] = reader.next();
+            if (!inputs[j] || !inputs[j]->good()) {
+                inputs[j].reset();
+                continue;
+            }
+            sizes[j] = inputs[j]->count();
+            position[j] = std::min(position[j], sizes[j]);
+            bytes_read += (sizes[j] - position[j]) * Graph::certSize(n - 1);
+            dispatch(j);
+        }
+        for (size_t i = todo.size() > window ? todo.size() - window : 0; i < todo.size(); i++) {
+            if (!finish(todo[i])) {
+                std::cout << "Could not save the checkpoint " << checkpoint.path() << std::endl;
+                return 1;
+            }
+        }
+
+        size_t q = 0;
+        std::vector<size_t> ve;
+        for (int e = 0; e <= E; e++) {
+            size_t qed = 0;
+            for (int d = 0; d < n && d <= e; d++) {
+                if (targets[e][d]) {
+                    Target& target = *targets[e][d];
+                    size_t count = target.size();
+                    if (count && canonical) {
+                        GrHeader header;
+                        header.type = GrHeader::graph;
+                        header.n = n;
+                        header.length = Graph::certSize(n);
+                        GrWriter writer(output, target.path, header);
+                        target.visitFound([&writer](const uint8_t* cert) {
+                            writer.add(cert);
                         });
+                    } else if (count) {
+                        target.graphs.write(output, target.path);
                     }
-                    for (int th = 0; th < num_threads; ++th) {
-                        threads[th].join();
+                    counts[e][d] = count;
+                    // the set and its run files are not needed anymore, unless
+                    // the run ends before the files are written and it is resumed
+                    if (!resumable) {
+                        targets[e][d].reset();
                     }
                 }
-                if (graphs.size()) {
+                if (counts[e][d]) {
                     while (qe.size() <= e) {
                         qe.push_back(0);
                     }
-
-                    qe[e] += graphs.size();
-                    qed += graphs.size();
-                    graphs.write(path);
+                    qe[e] += counts[e][d];
+                    qed += counts[e][d];
                 }
             }
             ve.push_back(qed);
             q += qed;
         }
+        // the level is done once its files are written
+        if (resumable) {
+            if (!output.wait()) {
+                std::cout << "Could not write the graphs on " << n << " vertices" << std::endl;
+                return 1;
+            }
+            checkpoint.remove();
+            targets.clear();
+        }
+        // a shard stops after its part of the first level not merged
+        if (build && shards > 1) {
+            if (!output.wait()) {
+                std::cout << "Could not write the graphs on " << n << " vertices" << std::endl;
+                return 1;
+            }
+            std::cout << q << " graphs on " << n << " vertices of the shard " << shard << "/" << shards
+                      << " are written to " << shard_address << std::endl;
+            return 0;
+        }
         if (q == 0) {
             break;
         }
@@ -394,5 +787,13 @@ int main(int argc, char** argv) {
     }
     std::cout << hor_line << std::endl;
     std::cout << last_line << std::endl;
+    // the busy time of the workers shows how well the work is balanced
+    std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+    std::cout << "busy time of the workers:";
+    for (double busy : pool.busyTimes()) {
+        std::cout << " " << std::round(busy * 1000) / 1000;
+    }
+    std::cout << " s of " << time.count() << " s" << std::endl;
+    std::cout << bytes_read << " bytes of parent files read, " << searches << " cone searches" << std::endl;
     return 0;
 }
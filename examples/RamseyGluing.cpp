@@ -2,18 +2,42 @@
 // with a given number of >= n given by the gluing
 // algorithm
 // Here we assume that G is K_3 or C_4 only.
+// With the option --shard=r/m the run is the shard r of m independent processes, possibly on
+// several machines: the i-th input graph of a degree d, counted over all its input files, is glued
+// by the shard i mod m. The shard builds the first n whose graphs are not in the directory of
+// R(G,k), writes its part to the subdirectory shard<r>-<m> and stops. The parts are merged by
+// grtool n merge <dir> <dir>/shard0-<m> ..., then the shards are run again for the next n
+// With the option --budget=M the sets of graphs of a degree take about M megabytes of memory
+// together, the rest is spilled to the disk and merged when the files are written
+// With the option --checkpoint=M the state of the degree being glued is saved every M minutes:
+// the sets found go to their run files and the positions reached in the input files to a .checkpoint
+// file. A run started again resumes from the checkpoint. The files of a degree are complete
+// once its checkpoint is removed
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
 #include <fstream>
+#include <numeric>
 #include <string>
 #include <sys/stat.h>
-#include <thread>
 
+#include "Checkpoint.h"
+#include "ExternalGraphSet.h"
 #include "Graph.h"
+#include "Pipeline.h"
+#include "TaskPool.h"
 
 const std::vector<std::string> names = {"K3", "C3", "C4", "3"};
 
 int num_threads = 8;
+// this process is the shard of that number out of shards
+size_t shard = 0;
+size_t shards = 1;
+// the input files loaded ahead by the reader and the files glued at once
+const size_t read_ahead = 2;
+const size_t window = 4;
 
 class Interval {
 public:
@@ -75,7 +99,7 @@ public:
         nextInterval(Intervals, 0);
     }
 
-    static std::vector<std::unique_ptr<GraphSet>> graphs;
+    static std::vector<std::unique_ptr<ExternalGraphSet>> graphs;
 
 private:
     void getFeasibleIntervals() {
@@ -281,7 +305,8 @@ private:
 
                 size_t edge = W.edges(); 
                 // if (Deg(HH) == d)
-                graphs[edge]->insert(W.certify());
+                W.certify();
+                graphs[edge]->insert(W);
             }
         }
     }
@@ -550,9 +575,30 @@ private:
     const size_t d;
 };
 
-std::vector<std::unique_ptr<GraphSet>> Glue::graphs;
+std::vector<std::unique_ptr<ExternalGraphSet>> Glue::graphs;
 
 int main(int argc, char** argv) {
+    double checkpoint_minutes = 0;
+    size_t budget = 0;
+    while (argc > 1 && std::string(argv[argc - 1]).substr(0, 2) == "--") {
+        std::string option = argv[argc - 1];
+        if (option.substr(0, 13) == "--checkpoint=") {
+            checkpoint_minutes = std::stod(option.substr(13));
+        } else if (option.substr(0, 9) == "--budget=") {
+            budget = std::stoull(option.substr(9)) << 20;
+        } else if (option.substr(0, 8) == "--shard=" && option.find('/') != std::string::npos) {
+            shard = std::stoull(option.substr(8));
+            shards = std::stoull(option.substr(option.find('/') + 1));
+            if (shards == 0 || shard >= shards) {
+                std::cout << "We expect the shard r/m with 0 <= r < m" << std::endl;
+                return 1;
+            }
+        } else {
+            std::cout << "Unknown option " << option << std::endl;
+            return 1;
+        }
+        argc--;
+    }
     if (argc != 4 && argc != 5) {
         std::cout << "Wrong number of arguments. We expect graph name G, positive integer k, and positive integer n to compute the set R(G, k, >=n)" << std::endl;
         return 1;
@@ -578,30 +624,55 @@ int main(int argc, char** argv) {
     const std::string address = "../data/RAMSEY/R(" + graph_name + "," + std::to_string(k - 1) + ")/";
     const std::string new_address = "../data/RAMSEY/R(" + graph_name + "," + std::to_string(k) + ")/";
     mkdir(new_address.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+    // the graphs found by a shard go to its own directory
+    const std::string shard_address = shards > 1 ? new_address + "shard" + std::to_string(shard) + "-" + std::to_string(shards) + "/" : new_address;
+    mkdir(shard_address.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
 
     size_t all = 0;
     std::vector<size_t> qv(n0);
     std::vector<size_t> qe;
     std::vector<std::vector<size_t>> qve(n0);
 
+    // the files are written in the background while the next ones are built
+    AsyncWriter output;
+    CheckpointClock clock(checkpoint_minutes * 60);
+    TaskPool pool(num_threads);
+    auto start = std::chrono::steady_clock::now();
+
     for (int n = n0;; n++) {
         size_t q = 0;
         std::vector<size_t> ve;
+        auto name = [&](int e, int d) {
+            return "R(" + graph_name + "," + std::to_string(k) + ";" + std::to_string(n) 
+                   + "," + std::to_string(e) + "," + std::to_string(d) + ").gr";
+        };
+        // a shard takes the graphs on n vertices as merged from all shards if some file is there
+        bool merged = false;
+        for (int d = 0; d < n && shards > 1; d++) {
+            for (int e = 0; e <= n * (n - 1) / 2; e++) {
+                if (GraphFile(new_address + name(e, d), n).good()) {
+                    merged = true;
+                }
+            }
+        }
+        const bool build = shards == 1 || !merged;
         for (int d = 0; d < n; d++) {
             if (graph_name == "C4" && d * d - d + 1 > n) {
                 break;
             }
 
+            // the checkpoint of a run which did not finish the degree d, its files may be incomplete
+            Checkpoint checkpoint(shard_address + "R(" + graph_name + "," + std::to_string(k) + ";" + std::to_string(n)
+                                  + "," + std::to_string(d) + ").checkpoint");
+            if (!build) {
+                checkpoint.clear();
+            }
             bool graphs_found = false;
-            for (int e = 0; e <= n * (n - 1) / 2; e++) {
-                std::string path = new_address + "R(" + graph_name + "," + std::to_string(k) + ";" + std::to_string(n) 
-                                 + "," + std::to_string(e) + "," + std::to_string(d) + ").gr";
-                std::ifstream file;
-                file.open(path, std::ios::in | std::ios::binary);
-                if (file.good()) {     
-                    graphs_found = true;               
-                    file.seekg(0, std::ios_base::end);
-                    size_t size = file.tellg() / Graph::certSize(n);
+            for (int e = 0; e <= n * (n - 1) / 2 && checkpoint.empty(); e++) {
+                const GraphFile done((build ? shard_address : new_address) + name(e, d), n);
+                if (done.good()) {
+                    graphs_found = true;
+                    size_t size = done.count();
                     while (ve.size() <= e) {
                         ve.push_back(0);
                     }
@@ -614,16 +685,18 @@ int main(int argc, char** argv) {
                 }
             }
 
-            if (graphs_found) {
+            if (graphs_found || !build) {
                 continue;
             }
 
             std::vector<Glue> glue;
+            // the sets of a degree are filled at once, so they share the budget
             Glue::graphs.resize(n * (n - 1) / 2 + 1);
+            const size_t share = budget ? std::max<size_t>(1, budget / Glue::graphs.size()) : 0;
             for (int i = 0; i < n * (n - 1) / 2 + 1; ++i) {
-                Glue::graphs[i] = std::make_unique<GraphSet>(n);
+                Glue::graphs[i] = std::make_unique<ExternalGraphSet>(n, share, shard_address + name(i, d));
             }
-            for (int th = 0; th < num_threads; ++th) {
+            for (size_t th = 0; th < pool.size(); ++th) {
                 glue.emplace_back(graph_name, n, k, d);
             }
 
@@ -642,56 +715,188 @@ int main(int argc, char** argv) {
                 }
             }
 
+            std::vector<std::string> paths;
             for (int e = (n - d - 2) * (n - d - 1) / 2; e >= 0; e--) {
                 for (int dd = n - d - 1; dd >= 0; dd--) {
                     if (graph_name == "C4" && dd + 1 < d) {
                         break;
                     }
+                    paths.push_back(address + "R(" + graph_name + "," + std::to_string(k - 1) + ";" + std::to_string(n - d - 1)
+                                  + "," + std::to_string(e) + "," + std::to_string(dd) + ").gr");
+                }
+            }
 
-                    std::string path = address + "R(" + graph_name + "," + std::to_string(k - 1) + ";" + std::to_string(n - d - 1) 
-                                 + "," + std::to_string(e) + "," + std::to_string(dd) + ").gr";
-                    std::fstream file;
-                    file.open(path, std::ios::in | std::ios::binary);
-                    if (file.good()) {
-                        size_t graph_size = Graph::certSize(n - d - 1);
-                        file.seekg(0, std::ios_base::end);
-                        size_t file_size = file.tellg();
-                        size_t block_size = file_size / graph_size / num_threads + 1;
-                        block_size *= graph_size;
-                        file.close();
-
-                        std::vector<std::thread> threads;
-                        for (int th = 0; th < num_threads; ++th) {
-                            threads.emplace_back([n, d, th, block_size, graph_size, file_size, &path, &glue, &hGraphs]{
-                            std::fstream stream;
-                            stream.open(path, std::ios::in | std::ios::binary);
-                            if (th * block_size >= file_size) {
-                                return;
-                            }          
-
-                            Graph G(n - d - 1);
-                            stream.seekg(th * block_size);
-                            for (int gr = 0; gr < block_size; gr += graph_size) {
-                                if (!readGraph(stream, G)) {
-                                    return;
-                                }
+            // the graphs of an input file before its position are done, sizes are the numbers of graphs
+            std::vector<size_t> position(paths.size(), 0);
+            std::vector<size_t> sizes(paths.size(), 0);
+            if (!checkpoint.empty()) {
+                // the lines of a damaged checkpoint are not used at all
+                bool restored = true;
+                for (const std::vector<size_t>& p : checkpoint.get("part")) {
+                    restored = restored && p.size() == 3 && p[0] < Glue::graphs.size();
+                }
+                for (const std::vector<size_t>& p : checkpoint.get("parent")) {
+                    restored = restored && p.size() == 3 && p[0] < paths.size() && p[1] <= p[2];
+                }
+                for (const std::vector<size_t>& p : checkpoint.get("part")) {
+                    restored = restored && Glue::graphs[p[0]]->restore(p[1], p[2]);
+                }
+                for (const std::vector<size_t>& p : checkpoint.get("parent")) {
+                    if (restored) {
+                        position[p[0]] = p[1];
+                        sizes[p[0]] = p[2];
+                    }
+                }
+                if (restored) {
+                    std::cout << "The graphs on " << n << " vertices of degree " << d << " are resumed from "
+                              << checkpoint.path() << std::endl;
+                } else {
+                    std::cout << "The checkpoint " << checkpoint.path() << " is damaged, the graphs on " << n
+                              << " vertices of degree " << d << " are built from the start" << std::endl;
+                    for (auto& graphs : Glue::graphs) {
+                        graphs->clear();
+                    }
+                    std::fill(position.begin(), position.end(), 0);
+                    std::fill(sizes.begin(), sizes.end(), 0);
+                }
+            }
+            // the files done before the checkpoint are not read again
+            std::vector<size_t> todo;
+            std::vector<std::string> todo_paths;
+            for (size_t j = 0; j < paths.size(); j++) {
+                if (position[j] == 0 || position[j] < sizes[j]) {
+                    todo.push_back(j);
+                    todo_paths.push_back(paths[j]);
+                }
+            }
 
-                                glue[th].setG(G);
-                                for (const Graph& H : hGraphs) {
-                                    glue[th].glueGH(H);
-                                }
+            // the reader loads the next input files while the workers glue the graphs
+            // of the window of files open before. A file is closed when its group is done
+            ReadAhead reader(todo_paths, n - d - 1, read_ahead);
+            std::vector<std::unique_ptr<const GraphFile>> inputs(paths.size());
+            std::vector<std::unique_ptr<ChunkCursor>> cursors(paths.size());
+            std::vector<std::unique_ptr<TaskPool::Group>> groups(paths.size());
+            // the workers glue the graphs of the file j from its position on
+            auto dispatch = [&](size_t j) {
+                const GraphFile& input = *inputs[j];
+                // the number of input graphs in the files before, which splits them among the shards
+                const size_t base = std::accumulate(sizes.begin(), sizes.begin() + j, size_t(0));
+                const size_t from = position[j];
+                // the graphs differ a lot in the number of their intervals, so the workers take small chunks
+                cursors[j].reset(new ChunkCursor(input.count() - from, pool.size()));
+                ChunkCursor& cursor = *cursors[j];
+                groups[j].reset(new TaskPool::Group(pool));
+
+                for (size_t t = 0; t < pool.size() && t < input.count() - from; ++t) {
+                    groups[j]->run([base, from, &pool, &clock, &input, &cursor, &glue, &hGraphs]{
+                    const size_t th = pool.worker();
+                    size_t first, last;
+                    while (!clock.due() && cursor.next(first, last)) {
+                        input.scan(from + first, from + last, [&](size_t i, const GraphView& V) {
+                            if ((base + i) % shards != shard) {
+                                return;
                             }
-                            });
+                            Graph G(V);
+                            glue[th].setG(G);
+                            for (const Graph& H : hGraphs) {
+                                glue[th].glueGH(H);
+                            }
+                        });
+                    }
+                    });
+                }
+            };
+            // the workers have stopped taking chunks: waits for the chunks taken, saves the sets
+            // and the positions in the input files and lets the workers go on.
+            // Returns false if a run file or the checkpoint could not be written
+            auto save = [&]() {
+                for (size_t j = 0; j < paths.size(); j++) {
+                    if (groups[j]) {
+                        groups[j]->wait();
+                        position[j] += cursors[j]->position();
+                        groups[j].reset();
+                    }
+                }
+                checkpoint.clear();
+                for (size_t j = 0; j < paths.size(); j++) {
+                    if (position[j]) {
+                        checkpoint.add("parent", {j, position[j], sizes[j]});
+                    }
+                }
+                for (size_t e = 0; e < Glue::graphs.size(); e++) {
+                    if (!Glue::graphs[e]->empty()) {
+                        size_t first = 0;
+                        const size_t runs = Glue::graphs[e]->checkpoint(first);
+                        if (!Glue::graphs[e]->good()) {
+                            return false;
                         }
-                        for (int th = 0; th < num_threads; ++th) {
-                            threads[th].join();
+                        checkpoint.add("part", {e, first, runs});
+                    }
+                }
+                checkpoint.write(output);
+                // the old checkpoint names the runs merged away, they are removed once the new one is written
+                if (!output.wait()) {
+                    return false;
+                }
+                for (auto& graphs : Glue::graphs) {
+                    graphs->committed();
+                }
+                clock.restart();
+                for (size_t j = 0; j < paths.size(); j++) {
+                    if (inputs[j] && position[j] < sizes[j]) {
+                        dispatch(j);
+                    }
+                }
+                return true;
+            };
+            // waits till the graphs of the file j are glued, saving the checkpoints due meanwhile.
+            // Returns false if a checkpoint could not be saved
+            auto finish = [&](size_t j) {
+                while (groups[j]) {
+                    groups[j]->wait();
+                    if (clock.paused()) {
+                        if (!save()) {
+                            return false;
                         }
+                    } else {
+                        position[j] = sizes[j];
+                        groups[j].reset();
                     }
                 }
+                inputs[j].reset();
+                return true;
+            };
+
+            for (size_t i = 0; i < todo.size(); i++) {
+                if (i >= window && !finish(todo[i - window])) {
+                    std::cout << "Could not save the checkpoint " << checkpoint.path() << std::endl;
+                    return 1;
+                }
+                const size_t j = todo[i];
+                inputs[j] = reader.next();
+                if (!inputs[j] || !inputs[j]->good()) {
+                    inputs[j].reset();
+                    continue;
+                }
+                sizes[j] = inputs[j]->count();
+                position[j] = std::min(position[j], sizes[j]);
+                dispatch(j);
+            }
+            for (size_t i = todo.size() > window ? todo.size() - window : 0; i < todo.size(); i++) {
+                if (!finish(todo[i])) {
+                    std::cout << "Could not save the checkpoint " << checkpoint.path() << std::endl;
+                    return 1;
+                }
+            }
+            // the files of the degree d are complete once the checkpoint is removed. A run which
+            // ends while they are written builds them again, from the start if nothing was saved
+            if (checkpoint.empty()) {
+                checkpoint.add("writing", {});
+                checkpoint.write(output);
             }
             bool empty = true;
             for (size_t e = 0; e <= n * (n - 1) / 2; e++) {
-                GraphSet& graphs = *Glue::graphs[e];
+                ExternalGraphSet& graphs = *Glue::graphs[e];
                 while (ve.size() <= e) {
                     ve.push_back(0);
                 }
@@ -701,14 +906,7 @@ int main(int argc, char** argv) {
                 } else {
                     empty = false;
                 }
-                std::string path = new_address + "R(" + graph_name + "," + std::to_string(k) + ";" + std::to_string(n) 
-                                               + "," + std::to_string(e) + "," + std::to_string(d) + ").gr";
-                std::ifstream file;
-                file.open(path, std::ios::in | std::ios::binary);
-                if (!file.good()) {
-                    file.close();
-                    graphs.write(path);
-                }
+                graphs.write(output, shard_address + name(e, d));
                 while (qe.size() <= e) {
                     qe.push_back(0);
                 }
@@ -716,10 +914,30 @@ int main(int argc, char** argv) {
                 qe[e] += graphs.size();
                 q += graphs.size();
             }
-            if (q && empty) {
+            if (!output.wait()) {
+                std::cout << "Could not write the graphs on " << n << " vertices" << std::endl;
+                return 1;
+            }
+            checkpoint.remove();
+            // the run files are not needed once the checkpoint is removed
+            for (auto& graphs : Glue::graphs) {
+                graphs->clear();
+            }
+            // a shard sees a part of the graphs, so it goes through all d
+            if (q && empty && shards == 1) {
                 break;
             }
         }
+        // a shard stops after its part of the first n not merged
+        if (build && shards > 1) {
+            if (!output.wait()) {
+                std::cout << "Could not write the graphs on " << n << " vertices" << std::endl;
+                return 1;
+            }
+            std::cout << q << " graphs on " << n << " vertices of the shard " << shard << "/" << shards
+                      << " are written to " << shard_address << std::endl;
+            return 0;
+        }
         if (q == 0) {
             break;
         }
@@ -789,5 +1007,12 @@ int main(int argc, char** argv) {
     }
     std::cout << hor_line << std::endl;
     std::cout << last_line << std::endl;
+    // the busy time of the workers shows how well the work is balanced
+    std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+    std::cout << "busy time of the workers:";
+    for (double busy : pool.busyTimes()) {
+        std::cout << " " << std::round(busy * 1000) / 1000;
+    }
+    std::cout << " s of " << time.count() << " s" << std::endl;
     return 0;
 }
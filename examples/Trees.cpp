@@ -41,8 +41,7 @@ int main() {
 
                 S.addEdge(i, n - 1);
                 S.certify();
-                if (!list.contains(S)) {
-                    list.insert(S);
+                if (list.insertIfAbsent(S)) {
                     trees.push_back(S);
                 }
                 S.killEdge(i, n - 1);
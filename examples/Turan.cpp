@@ -3,14 +3,17 @@
 #include <algorithm>
 #include <vector>
 #include <iostream>
+#include <set>
 #include <sstream>
 #include <string>
 #include <sys/stat.h>
-#include <thread>
 #include <chrono>
-#include <mutex>
+#include <cmath>
 
 #include "Graph.h"
+#include "Matcher.h"
+#include "Pipeline.h"
+#include "TaskPool.h"
 
 #define VERBOSE 1
 
@@ -20,7 +23,7 @@ int num_threads = 8;
 
 class Turan {
 public:
-    Turan(const std::string& graph_name) : graph_name(graph_name) {
+    Turan(const std::string& graph_name) : pool(num_threads), graph_name(graph_name) {
         initH();
 
         mkdir("../data/", S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
@@ -51,8 +54,8 @@ public:
         std::string filename = address + "Critical/Cr(" + std::to_string(Hn - 1) + ", " + graph_name + ").gr";
         one.write(filename);
 
-        DG.resize(num_threads);
-        cycles.resize(num_threads);
+        DG.resize(pool.size());
+        cycles.resize(pool.size());
     }
 
     void initH() {
@@ -84,6 +87,7 @@ public:
             H = Q(3);
         }
 
+        matcher = SubgraphMatcher(H);
         dH = H.deg();
         Hn = H.size();
         He = H.edges();
@@ -107,7 +111,8 @@ public:
         return Hn;
     }
 
-    std::pair<int, int> compute(int n) {
+    // the Turan number and the number of extremal graphs, false if a file could not be written
+    bool compute(int n, int& ex_n, int& qx_n) {
         N = n;
         while (N >= ln.size()) {
             ln.push_back(0);
@@ -126,23 +131,36 @@ public:
 
         ln[N] = un[N];
         getBounds(N - 1);
-        getGraphs();
+        if (!getGraphs()) {
+            return false;
+        }
 
         while (EX.empty()) {
             un[N]--;
             ln[N]--;
  
             getBounds(N - 1);
-            getGraphs();
+            if (!getGraphs()) {
+                return false;
+            }
         }
 
         std::string path = address + "Extremal/EX(" + std::to_string(n) + ", " + graph_name + ").gr";
         qx[N] = EX.size();
         ex[N] = ln[N];
-        EX.write(path);
+        EX.write(output, path);
         EX.clear();
 
-        return {ex[N], qx[N]};
+        ex_n = ex[N];
+        qx_n = qx[N];
+        return true;
+    }
+
+    // the busy time of every worker since the last call
+    std::vector<double> busyTimes() {
+        std::vector<double> times = pool.busyTimes();
+        pool.resetBusyTimes();
+        return times;
     }
 
 private:
@@ -150,321 +168,11 @@ private:
     void getCycles(const Graph& G, int th) {
         size_t n = G.size();
         cycles[th].clear();
-        std::vector<size_t> g(Hn);
-        if (graph_name == "C4") { // k -- i -- (n - 1) -- j -- k
-            for (size_t i = 0; i < n - 1; i++) if (G.edge(i, n - 1))
-            for (size_t j = i + 1; j < n - 1; j++) if (G.edge(j, n - 1))
-            for (size_t k = 0; k < n - 1; k++) if (G.edge(i, k) && G.edge(j, k)) {
-                 g[0] = n - 1;
-                 g[1] = i;
-                 g[2] = k;
-                 g[3] = j;
-                 cycles[th].emplace_back(g);
-            }
-        } else if (graph_name == "C6") { //   k -- j1 -- i1 -- (n - 1) -- i2 -- j2 -- k
-            for (size_t i1 = 0; i1 < n - 1; i1++) if (G.edge(i1, n - 1))
-            for (size_t i2 = i1 + 1; i2 < n - 1; i2++) if (G.edge(i2, n - 1))
-            for (size_t j1 = 0; j1 < n - 1; j1++)      if (G.edge(j1, i1) && j1 != i2)
-            for (size_t j2 = 0; j2 < n - 1; j2++)      if (G.edge(j2, i2) && j2 != i1 && j2 != j1)
-            for (size_t k = 0; k < n - 1; k++)	if (G.edge(k, j1) && G.edge(k, j2) && k != i1 && k != i2) {
-                 g[0] = n - 1;
-                 g[1] = i1;
-                 g[2] = j1;
-                 g[3] = k;
-                 g[4] = j2;
-                 g[5] = i2;
-                 cycles[th].emplace_back(g);
-            }
-        } else if (graph_name == "C8") { //   k -- l1 -- j1 -- i1 -- (n - 1) -- i2 -- j2 -- l2 -- k
-            for (size_t i1 = 0; i1 < n - 1; i1++) if (G.edge(i1, n - 1))
-            for (size_t i2 = i1 + 1; i2 < n - 1; i2++) if (G.edge(i2, n - 1))
-            for (size_t j1 = 0; j1 < n - 1; j1++)      if (G.edge(j1, i1) && j1 != i2)
-            for (size_t j2 = 0; j2 < n - 1; j2++)      if (G.edge(j2, i2) && j2 != i1 && j2 != j1)
-            for (size_t l1 = 0; l1 < n - 1; l1++)      if (G.edge(l1, j1) && l1 != i1 && l1 != i2 && l1 != j2)
-            for (size_t l2 = 0; l2 < n - 1; l2++)      if (G.edge(l2, j2) && l2 != i1 && l2 != i2 && l2 != j1 && l1 != l2)
-            for (size_t k = 0; k < n - 1; k++)	if (G.edge(k, l1) && G.edge(k, l2) && k != i1 && k != i2 && k != j1 && k != j2) {
-                 g[0] = n - 1;
-                 g[1] = i1;
-                 g[2] = j1;
-                 g[3] = l1;
-                 g[4] = k;
-                 g[5] = l2;
-                 g[6] = j2;
-                 g[7] = i2;
-                 cycles[th].emplace_back(g);
-            }
-        } else if (graph_name == "K23") { // (n - 1), i =-= j0, j1, j2
-            for (size_t i = 0; i < n - 1; i++)
-            for (size_t j0 = 0; j0 < n - 1; j0++)	if (G.edge(j0, n - 1) && G.edge(j0, i))
-            for (size_t j1 = j0 + 1; j1 < n - 1; j1++)	if (G.edge(j1, n - 1) && G.edge(j1, i))
-            for (size_t j2 = j1 + 1; j2 < n - 1; j2++)	if (G.edge(j2, n - 1) && G.edge(j2, i)) {
-                 g[0] = n - 1;
-                 g[1] = i;
-                 g[2] = j0;
-                 g[3] = j1;
-                 g[4] = j2;
-                 cycles[th].emplace_back(g);
-            }                             // (n - 1), i1, i2 =-= j0, j1
-            for (size_t i1 = 0; i1 < n - 1; i1++)
-            for (size_t i2 = i1 + 1; i2 < n - 1; i2++)
-            for (size_t j0 = 0; j0 < n - 1; j0++)	if (G.edge(j0, n - 1) && G.edge(j0, i1) && G.edge(j0, i2))
-            for (size_t j1 = j0 + 1; j1 < n - 1; j1++)	if (G.edge(j1, n - 1) && G.edge(j1, i1) && G.edge(j1, i2)) {
-                 g[0] = j0;
-                 g[1] = j1;
-                 g[2] = n - 1;
-                 g[3] = i1;
-                 g[4] = i2;
-                 cycles[th].emplace_back(g);
-            }
-        } else if (graph_name == "K24") { // (n - 1), i =-= j0, j1, j2, j3
-            for (size_t i = 0; i < n - 1; i++)
-            for (size_t j0 = 0; j0 < n - 1; j0++)	if (G.edge(j0, n - 1) && G.edge(j0, i))
-            for (size_t j1 = j0 + 1; j1 < n - 1; j1++)	if (G.edge(j1, n - 1) && G.edge(j1, i))
-            for (size_t j2 = j1 + 1; j2 < n - 1; j2++)	if (G.edge(j2, n - 1) && G.edge(j2, i))
-            for (size_t j3 = j2 + 1; j3 < n - 1; j3++)	if (G.edge(j3, n - 1) && G.edge(j3, i)) {
-                 g[0] = n - 1;
-                 g[1] = i;
-                 g[2] = j0;
-                 g[3] = j1;
-                 g[4] = j2;
-                 g[5] = j3;
-                 cycles[th].emplace_back(g);
-            }                             // (n - 1), i1, i2, i3 =-= j0, j1
-            for (size_t i1 = 0; i1 < n - 1; i1++)
-            for (size_t i2 = i1 + 1; i2 < n - 1; i2++)
-            for (size_t i3 = i2 + 1; i3 < n - 1; i3++)
-            for (size_t j0 = 0; j0 < n - 1; j0++)	if (G.edge(j0, n - 1) && G.edge(j0, i1) && G.edge(j0, i2) && G.edge(j0, i3))
-            for (size_t j1 = j0 + 1; j1 < n - 1; j1++)	if (G.edge(j1, n - 1) && G.edge(j1, i1) && G.edge(j1, i2) && G.edge(j1, i3)) {
-                 g[0] = j0;
-                 g[1] = j1;
-                 g[2] = n - 1;
-                 g[3] = i1;
-                 g[4] = i2;
-                 g[5] = i3;
-                 cycles[th].emplace_back(g);
-            }
-        } else if (graph_name == "K25") { // (n - 1), i =-= j0, j1, j2, j3, j4
-            for (size_t i = 0; i < n - 1; i++)
-            for (size_t j0 = 0; j0 < n - 1; j0++)	if (G.edge(j0, n - 1) && G.edge(j0, i))
-            for (size_t j1 = j0 + 1; j1 < n - 1; j1++)	if (G.edge(j1, n - 1) && G.edge(j1, i))
-            for (size_t j2 = j1 + 1; j2 < n - 1; j2++)	if (G.edge(j2, n - 1) && G.edge(j2, i))
-            for (size_t j3 = j2 + 1; j3 < n - 1; j3++)	if (G.edge(j3, n - 1) && G.edge(j3, i))
-            for (size_t j4 = j3 + 1; j4 < n - 1; j4++)	if (G.edge(j4, n - 1) && G.edge(j4, i)) {
-                 g[0] = n - 1;
-                 g[1] = i;
-                 g[2] = j0;
-                 g[3] = j1;
-                 g[4] = j2;
-                 g[5] = j3;
-                 g[6] = j4;
-                 cycles[th].emplace_back(g);
-            }                             // (n - 1), i1, i2, i3 =-= j0, j1, j2
-            for (size_t i1 = 0; i1 < n - 1; i1++)
-            for (size_t i2 = i1 + 1; i2 < n - 1; i2++)
-            for (size_t i3 = i2 + 1; i3 < n - 1; i3++)
-            for (size_t j0 = 0; j0 < n - 1; j0++)	if (G.edge(j0, n - 1) && G.edge(j0, i1) && G.edge(j0, i2) && G.edge(j0, i3))
-            for (size_t j1 = j0 + 1; j1 < n - 1; j1++)	if (G.edge(j1, n - 1) && G.edge(j1, i1) && G.edge(j1, i2) && G.edge(j1, i3))
-            for (size_t j2 = j1 + 1; j2 < n - 1; j2++)	if (G.edge(j2, n - 1) && G.edge(j2, i1) && G.edge(j2, i2) && G.edge(j2, i3)) {
-                 g[0] = j0;
-                 g[1] = j1;
-                 g[2] = j2;
-                 g[3] = n - 1;
-                 g[4] = i1;
-                 g[5] = i2;
-                 g[6] = i3;
-                 cycles[th].emplace_back(g);
-            }
-        } else if (graph_name == "K26") { // (n - 1), i =-= j0, j1, j2, j3, j4, j5
-            for (size_t i = 0; i < n - 1; i++)
-            for (size_t j0 = 0; j0 < n - 1; j0++)	if (G.edge(j0, n - 1) && G.edge(j0, i))
-            for (size_t j1 = j0 + 1; j1 < n - 1; j1++)	if (G.edge(j1, n - 1) && G.edge(j1, i))
-            for (size_t j2 = j1 + 1; j2 < n - 1; j2++)	if (G.edge(j2, n - 1) && G.edge(j2, i))
-            for (size_t j3 = j2 + 1; j3 < n - 1; j3++)	if (G.edge(j3, n - 1) && G.edge(j3, i))
-            for (size_t j4 = j3 + 1; j4 < n - 1; j4++)	if (G.edge(j4, n - 1) && G.edge(j4, i))
-            for (size_t j5 = j4 + 1; j5 < n - 1; j5++)	if (G.edge(j5, n - 1) && G.edge(j5, i)) {
-                 g[0] = n - 1;
-                 g[1] = i;
-                 g[2] = j0;
-                 g[3] = j1;
-                 g[4] = j2;
-                 g[5] = j3;
-                 g[6] = j4;
-                 g[7] = j5;
-                 cycles[th].emplace_back(g);
-            }                             // (n - 1), i1, i2, i3, i4, i5 =-= j0, j1
-            for (size_t i1 = 0; i1 < n - 1; i1++)
-            for (size_t i2 = i1 + 1; i2 < n - 1; i2++)
-            for (size_t i3 = i2 + 1; i3 < n - 1; i3++)
-            for (size_t i4 = i3 + 1; i4 < n - 1; i4++)
-            for (size_t i5 = i4 + 1; i5 < n - 1; i5++)
-            for (size_t j0 = 0; j0 < n - 1; j0++)	if (G.edge(j0, n - 1) && G.edge(j0, i1) && G.edge(j0, i2) && G.edge(j0, i3) && G.edge(j0, i4) && G.edge(j0, i5))
-            for (size_t j1 = j0 + 1; j1 < n - 1; j1++)	if (G.edge(j1, n - 1) && G.edge(j1, i1) && G.edge(j1, i2) && G.edge(j1, i3) && G.edge(j1, i4) && G.edge(j1, i5)) {
-                 g[0] = j0;
-                 g[1] = j1;
-                 g[2] = n - 1;
-                 g[3] = i1;
-                 g[4] = i2;
-                 g[5] = i3;
-                 g[6] = i4;
-                 g[7] = i5;
-                 cycles[th].emplace_back(g);
-            }
-        } else if (graph_name == "K33") { // (n - 1), i1, i2 =-= j0, j1, j2
-            for (size_t i1 = 0; i1 < n - 1; i1++)
-            for (size_t i2 = i1 + 1; i2 < n - 1; i2++)
-            for (size_t j0 = 0; j0 < n - 1; j0++)	if (G.edge(j0, n - 1) && G.edge(j0, i1) && G.edge(j0, i2))
-            for (size_t j1 = j0 + 1; j1 < n - 1; j1++)	if (G.edge(j1, n - 1) && G.edge(j1, i1) && G.edge(j1, i2))
-            for (size_t j2 = j1 + 1; j2 < n - 1; j2++)	if (G.edge(j2, n - 1) && G.edge(j2, i1) && G.edge(j2, i2)) {
-                 g[0] = n - 1;
-                 g[1] = i1;
-                 g[2] = i2;
-                 g[3] = j0;
-                 g[4] = j1;
-                 g[5] = j2;
-                 cycles[th].emplace_back(g);
-            }
-        } else if (graph_name == "K34") { // (n - 1), i1, i2 =-= j0, j1, j2, j3
-            for (size_t i1 = 0; i1 < n - 1; i1++)
-            for (size_t i2 = i1 + 1; i2 < n - 1; i2++)
-            for (size_t j0 = 0; j0 < n - 1; j0++)	if (G.edge(j0, n - 1) && G.edge(j0, i1) && G.edge(j0, i2))
-            for (size_t j1 = j0 + 1; j1 < n - 1; j1++)	if (G.edge(j1, n - 1) && G.edge(j1, i1) && G.edge(j1, i2))
-            for (size_t j2 = j1 + 1; j2 < n - 1; j2++)	if (G.edge(j2, n - 1) && G.edge(j2, i1) && G.edge(j2, i2))
-            for (size_t j3 = j2 + 1; j3 < n - 1; j3++)	if (G.edge(j3, n - 1) && G.edge(j3, i1) && G.edge(j3, i2)) {
-                 g[0] = n - 1;
-                 g[1] = i1;
-                 g[2] = i2;
-                 g[3] = j0;
-                 g[4] = j1;
-                 g[5] = j2;
-                 g[6] = j3;
-                 cycles[th].emplace_back(g);
-            }                             // (n - 1), i1, i2, i3 =-= j0, j1, j2
-            for (size_t i1 = 0; i1 < n - 1; i1++)
-            for (size_t i2 = i1 + 1; i2 < n - 1; i2++)
-            for (size_t i3 = i2 + 1; i3 < n - 1; i3++)
-            for (size_t j0 = 0; j0 < n - 1; j0++)	if (G.edge(j0, n - 1) && G.edge(j0, i1) && G.edge(j0, i2) && G.edge(j0, i3))
-            for (size_t j1 = j0 + 1; j1 < n - 1; j1++)	if (G.edge(j1, n - 1) && G.edge(j1, i1) && G.edge(j1, i2) && G.edge(j1, i3))
-            for (size_t j2 = j1 + 1; j2 < n - 1; j2++)	if (G.edge(j2, n - 1) && G.edge(j2, i1) && G.edge(j2, i2) && G.edge(j2, i3)) {
-                 g[0] = j0;
-                 g[1] = j1;
-                 g[2] = j2;
-                 g[3] = n - 1;
-                 g[4] = i1;
-                 g[5] = i2;
-                 g[6] = i3;
-                 cycles[th].emplace_back(g);
-            }
-        } else if (graph_name == "K35") { // (n - 1), i1, i2 =-= j0, j1, j2, j3, j4
-            for (size_t i1 = 0; i1 < n - 1; i1++)
-            for (size_t i2 = i1 + 1; i2 < n - 1; i2++)
-            for (size_t j0 = 0; j0 < n - 1; j0++)	if (G.edge(j0, n - 1) && G.edge(j0, i1) && G.edge(j0, i2))
-            for (size_t j1 = j0 + 1; j1 < n - 1; j1++)	if (G.edge(j1, n - 1) && G.edge(j1, i1) && G.edge(j1, i2))
-            for (size_t j2 = j1 + 1; j2 < n - 1; j2++)	if (G.edge(j2, n - 1) && G.edge(j2, i1) && G.edge(j2, i2))
-            for (size_t j3 = j2 + 1; j3 < n - 1; j3++)	if (G.edge(j3, n - 1) && G.edge(j3, i1) && G.edge(j3, i2))
-            for (size_t j4 = j3 + 1; j4 < n - 1; j4++)	if (G.edge(j4, n - 1) && G.edge(j4, i1) && G.edge(j4, i2)) {
-                 g[0] = n - 1;
-                 g[1] = i1;
-                 g[2] = i2;
-                 g[3] = j0;
-                 g[4] = j1;
-                 g[5] = j2;
-                 g[6] = j3;
-                 g[7] = j4;
-                 cycles[th].emplace_back(g);
-            }                             // (n - 1), i1, i2, i3, i4 =-= j0, j1, j2
-            for (size_t i1 = 0; i1 < n - 1; i1++)
-            for (size_t i2 = i1 + 1; i2 < n - 1; i2++)
-            for (size_t i3 = i2 + 1; i3 < n - 1; i3++)
-            for (size_t i4 = i3 + 1; i4 < n - 1; i4++)
-            for (size_t j0 = 0; j0 < n - 1; j0++)	if (G.edge(j0, n - 1) && G.edge(j0, i1) && G.edge(j0, i2) && G.edge(j0, i3) && G.edge(j0, i4))
-            for (size_t j1 = j0 + 1; j1 < n - 1; j1++)	if (G.edge(j1, n - 1) && G.edge(j1, i1) && G.edge(j1, i2) && G.edge(j1, i3) && G.edge(j1, i4))
-            for (size_t j2 = j1 + 1; j2 < n - 1; j2++)	if (G.edge(j2, n - 1) && G.edge(j2, i1) && G.edge(j2, i2) && G.edge(j2, i3) && G.edge(j2, i4)) {
-                 g[0] = j0;
-                 g[1] = j1;
-                 g[2] = j2;
-                 g[3] = n - 1;
-                 g[4] = i1;
-                 g[5] = i2;
-                 g[6] = i3;
-                 g[7] = i4;
-                 cycles[th].emplace_back(g);
-            }
-        } else if (graph_name == "K36") { // (n - 1), i1, i2 =-= j0, j1, j2, j3, j4, j5
-            for (size_t i1 = 0; i1 < n - 1; i1++)
-            for (size_t i2 = i1 + 1; i2 < n - 1; i2++)
-            for (size_t j0 = 0; j0 < n - 1; j0++)	if (G.edge(j0, n - 1) && G.edge(j0, i1) && G.edge(j0, i2))
-            for (size_t j1 = j0 + 1; j1 < n - 1; j1++)	if (G.edge(j1, n - 1) && G.edge(j1, i1) && G.edge(j1, i2))
-            for (size_t j2 = j1 + 1; j2 < n - 1; j2++)	if (G.edge(j2, n - 1) && G.edge(j2, i1) && G.edge(j2, i2))
-            for (size_t j3 = j2 + 1; j3 < n - 1; j3++)	if (G.edge(j3, n - 1) && G.edge(j3, i1) && G.edge(j3, i2))
-            for (size_t j4 = j3 + 1; j4 < n - 1; j4++)	if (G.edge(j4, n - 1) && G.edge(j4, i1) && G.edge(j4, i2))
-            for (size_t j5 = j4 + 1; j5 < n - 1; j5++)	if (G.edge(j5, n - 1) && G.edge(j5, i1) && G.edge(j5, i2)) {
-                 g[0] = n - 1;
-                 g[1] = i1;
-                 g[2] = i2;
-                 g[3] = j0;
-                 g[4] = j1;
-                 g[5] = j2;
-                 g[6] = j3;
-                 g[7] = j4;
-                 g[8] = j5;
-                 cycles[th].emplace_back(g);
-            }                             // (n - 1), i1, i2, i3, i4, i5 =-= j0, j1, j2
-            for (size_t i1 = 0; i1 < n - 1; i1++)
-            for (size_t i2 = i1 + 1; i2 < n - 1; i2++)
-            for (size_t i3 = i2 + 1; i3 < n - 1; i3++)
-            for (size_t i4 = i3 + 1; i4 < n - 1; i4++)
-            for (size_t i5 = i4 + 1; i5 < n - 1; i5++)
-            for (size_t j0 = 0; j0 < n - 1; j0++)	if (G.edge(j0, n - 1) && G.edge(j0, i1) && G.edge(j0, i2) && G.edge(j0, i3) && G.edge(j0, i4) && G.edge(j0, i5))
-            for (size_t j1 = j0 + 1; j1 < n - 1; j1++)	if (G.edge(j1, n - 1) && G.edge(j1, i1) && G.edge(j1, i2) && G.edge(j1, i3) && G.edge(j1, i4) && G.edge(j1, i5))
-            for (size_t j2 = j1 + 1; j2 < n - 1; j2++)	if (G.edge(j2, n - 1) && G.edge(j2, i1) && G.edge(j2, i2) && G.edge(j2, i3) && G.edge(j2, i4) && G.edge(j2, i5)) {
-                 g[0] = j0;
-                 g[1] = j1;
-                 g[2] = j2;
-                 g[3] = n - 1;
-                 g[4] = i1;
-                 g[5] = i2;
-                 g[6] = i3;
-                 g[7] = i4;
-                 g[8] = i5;
-                 cycles[th].emplace_back(g);
-            }
-        } else if (graph_name == "K44") { // (n - 1), i1, i2, i3 =-= j0, j1, j2, j3
-            for (size_t i1 = 0; i1 < n - 1; i1++)
-            for (size_t i2 = i1 + 1; i2 < n - 1; i2++)
-            for (size_t i3 = i2 + 1; i3 < n - 1; i3++)
-            for (size_t j0 = 0; j0 < n - 1; j0++)	if (G.edge(j0, n - 1) && G.edge(j0, i1) && G.edge(j0, i2) && G.edge(j0, i3))
-            for (size_t j1 = j0 + 1; j1 < n - 1; j1++)	if (G.edge(j1, n - 1) && G.edge(j1, i1) && G.edge(j1, i2) && G.edge(j1, i3))
-            for (size_t j2 = j1 + 1; j2 < n - 1; j2++)	if (G.edge(j2, n - 1) && G.edge(j2, i1) && G.edge(j2, i2) && G.edge(j2, i3))
-            for (size_t j3 = j2 + 1; j3 < n - 1; j3++)	if (G.edge(j3, n - 1) && G.edge(j3, i1) && G.edge(j3, i2) && G.edge(j3, i3)) {
-                 g[0] = n - 1;
-                 g[1] = i1;
-                 g[2] = i2;
-                 g[3] = i3;
-                 g[4] = j0;
-                 g[5] = j1;
-                 g[6] = j2;
-                 g[7] = j3;
-                 cycles[th].emplace_back(g);
-            }
-        } else if (graph_name == "Q3") {                                     
-            for (size_t i1 = 0; i1 < n - 1; ++i1) if (G.edge(i1, n - 1))     
-            for (size_t i2 = i1 + 1; i2 < n - 1; ++i2) if (G.edge(i2, n - 1))
-            for (size_t i3 = i2 + 1; i3 < n - 1; ++i3) if (G.edge(i3, n - 1))
-            for (size_t j1 = 0; j1 < n - 1; ++j1) if (G.edge(j1, i1) && G.edge(j1, i2) && j1 != i3)  
-            for (size_t j2 = 0; j2 < n - 1; ++j2) if (G.edge(j2, i1) && G.edge(j2, i3) && j2 != j1 && j2 != i2)
-            for (size_t j3 = 0; j3 < n - 1; ++j3) if (G.edge(j3, i2) && G.edge(j3, i3) && j3 != j1 && j3 != j2 && j3 != i1)  
-            for (size_t k = 0; k < n - 1; ++k) if (G.edge(k, j1) && G.edge(k, j2) && G.edge(k, j3) && k != i1 && k != i2 && k != i3) {
-                 g[0] = n - 1;
-                 g[1] = i1;
-                 g[2] = i2;
-                 g[3] = j1;
-                 g[4] = i3;
-                 g[5] = j2;
-                 g[6] = j3;
-                 g[7] = k;
-                 cycles[th].emplace_back(g);
-            }
-        }
+        // all copies of H through the new vertex (n - 1), each one once
+        matcher.enumerate(G, n - 1, [this, th](const std::vector<size_t>& g) {
+            cycles[th].push_back(g);
+            return true;
+        });
     }
 
     void next(int level, int n) {
@@ -498,171 +206,13 @@ private:
 
     bool critical(Graph& G) {
         size_t n = G.size();
+        // adding any missing edge must create a copy of H
         for (int ii = 0; ii < n; ii++) {
             for (int jj = ii + 1; jj < n; jj++) {
                 if (G.edge(ii, jj)) {
                     continue;
                 }
-
-                G.addEdge(ii, jj);
-
-                bool BB = false;
-                if (graph_name == "C4") { // i -- ii -- jj -- j
-                    for (int i = 0; i < n && !BB; i++) if (G.edge(i, ii))
-                    for (int j = 0; j < n && !BB; j++) if (G.edge(j, jj) && G.edge(i, j)) {
-                        BB = true;
-                    }
-                } else if (graph_name == "C6") { //  i2 -- i1 -- ii -- jj -- j1 -- j2 -- i2
-                    for (int i1 = 0; i1 < n && !BB; i1++) if (G.edge(i1, ii) && i1 != jj)
-                    for (int j1 = 0; j1 < n && !BB; j1++) if (G.edge(j1, jj) && j1 != ii && j1 != i1)
-                    for (int i2 = 0; i2 < n && !BB; i2++) if (G.edge(i1, i2) && i2 != j1 && i2 != ii && i2 != jj)
-                    for (int j2 = 0; j2 < n && !BB; j2++) if (G.edge(j1, j2) && G.edge(i2, j2) && j2 != i1 && j2 != ii && j2 != jj) {
-                        BB = true;
-                    }
-                } else if (graph_name == "C8") { //  i3 -- i2 -- i1 -- ii -- jj -- j1 -- j2 -- i2 -- i3
-                    for (int i1 = 0; i1 < n && !BB; i1++) if (G.edge(i1, ii) && i1 != jj)
-                    for (int j1 = 0; j1 < n && !BB; j1++) if (G.edge(j1, jj) && j1 != ii && j1 != i1)
-                    for (int i2 = 0; i2 < n && !BB; i2++) if (G.edge(i1, i2) && i2 != j1 && i2 != ii && i2 != jj)
-                    for (int j2 = 0; j2 < n && !BB; j2++) if (G.edge(j1, j2) && j2 != i2 && j2 != i1 && j2 != ii && j2 != jj)
-                    for (int i3 = 0; i3 < n && !BB; i3++) if (G.edge(i2, i3) && i3 != j2 && i3 != i2 && i3 != j1 && i3 != ii && i3 != jj)
-                    for (int j3 = 0; j3 < n && !BB; j3++) if (G.edge(j2, j3) && G.edge(i3, j3) && j3 != i2 && j3 != j1 && j3 != ii && j3 != jj) {
-                        BB = true;
-                    }
-                } else if (graph_name == "K23") { // i1, ii =-= jj, j1, j2
-                    for (int i1 = 0; i1 < n && !BB; i1++) if (i1 != ii && G.edge(i1, jj))
-                    for (int j1 = 0; j1 < n && !BB; j1++) if (jj != j1 && G.edge(ii, j1) && G.edge(i1, j1))
-                    for (int j2 = j1 + 1; j2 < n && !BB; j2++) if (jj != j2 && G.edge(ii, j2) && G.edge(i1, j2)) {
-                        BB = true;
-                    }                             // i1, i2, ii =-= jj, j1
-                    for (int i1 = 0; i1 < n && !BB; i1++) if (i1 != ii && G.edge(i1, jj))
-                    for (int i2 = i1 + 1; i2 < n && !BB; i2++) if (i2 != ii && G.edge(i2, jj))
-                    for (int j1 = 0; j1 < n && !BB; j1++) if (jj != j1 && G.edge(ii, j1) && G.edge(i1, j1) && G.edge(i2, j1)) {
-                        BB = true;
-                    }
-                } else if (graph_name == "K24") { // i1, ii =-= jj, j1, j2, j3
-                    for (int i1 = 0; i1 < n && !BB; i1++) if (i1 != ii && G.edge(i1, jj))
-                    for (int j1 = 0; j1 < n && !BB; j1++) if (jj != j1 && G.edge(ii, j1) && G.edge(i1, j1))
-                    for (int j2 = j1 + 1; j2 < n && !BB; j2++) if (jj != j2 && G.edge(ii, j2) && G.edge(i1, j2))
-                    for (int j3 = j2 + 1; j3 < n && !BB; j3++) if (jj != j3 && G.edge(ii, j3) && G.edge(i1, j3)) {
-                        BB = true;
-                    }                             // i1, i2, i3, ii =-= jj, j1
-                    for (int i1 = 0; i1 < n && !BB; i1++) if (i1 != ii && G.edge(i1, jj))
-                    for (int i2 = i1 + 1; i2 < n && !BB; i2++) if (i2 != ii && G.edge(i2, jj))
-                    for (int i3 = i2 + 1; i3 < n && !BB; i3++) if (i3 != ii && G.edge(i3, jj))
-                    for (int j1 = 0; j1 < n && !BB; j1++) if (jj != j1 && G.edge(ii, j1) && G.edge(i1, j1) && G.edge(i2, j1) && G.edge(i3, j1)) {
-                        BB = true;
-                    }
-                } else if (graph_name == "K25") { // i1, ii =-= jj, j1, j2, j3, j4
-                    for (int i1 = 0; i1 < n && !BB; i1++) if (i1 != ii && G.edge(i1, jj))
-                    for (int j1 = 0; j1 < n && !BB; j1++) if (jj != j1 && G.edge(ii, j1) && G.edge(i1, j1))
-                    for (int j2 = j1 + 1; j2 < n && !BB; j2++) if (jj != j2 && G.edge(ii, j2) && G.edge(i1, j2))
-                    for (int j3 = j2 + 1; j3 < n && !BB; j3++) if (jj != j3 && G.edge(ii, j3) && G.edge(i1, j3))
-                    for (int j4 = j3 + 1; j4 < n && !BB; j4++) if (jj != j4 && G.edge(ii, j4) && G.edge(i1, j4)) {
-                        BB = true;
-                    }                             // i1, i2, i3, i4, ii =-= jj, j1
-                    for (int i1 = 0; i1 < n && !BB; i1++) if (i1 != ii && G.edge(i1, jj))
-                    for (int i2 = i1 + 1; i2 < n && !BB; i2++) if (i2 != ii && G.edge(i2, jj))
-                    for (int i3 = i2 + 1; i3 < n && !BB; i3++) if (i3 != ii && G.edge(i3, jj))
-                    for (int i4 = i3 + 1; i4 < n && !BB; i4++) if (i4 != ii && G.edge(i4, jj))
-                    for (int j1 = 0; j1 < n && !BB; j1++) if (jj != j1 && G.edge(ii, j1) && G.edge(i1, j1) && G.edge(i2, j1) && G.edge(i3, j1) && G.edge(i4, j1)) {
-                        BB = true;
-                    }
-                } else if (graph_name == "K26") { // i1, ii =-= jj, j1, j2, j3, j4, j5
-                    for (int i1 = 0; i1 < n && !BB; i1++) if (i1 != ii && G.edge(i1, jj))
-                    for (int j1 = 0; j1 < n && !BB; j1++) if (jj != j1 && G.edge(ii, j1) && G.edge(i1, j1))
-                    for (int j2 = j1 + 1; j2 < n && !BB; j2++) if (jj != j2 && G.edge(ii, j2) && G.edge(i1, j2))
-                    for (int j3 = j2 + 1; j3 < n && !BB; j3++) if (jj != j3 && G.edge(ii, j3) && G.edge(i1, j3))
-                    for (int j4 = j3 + 1; j4 < n && !BB; j4++) if (jj != j4 && G.edge(ii, j4) && G.edge(i1, j4))
-                    for (int j5 = j4 + 1; j5 < n && !BB; j5++) if (jj != j5 && G.edge(ii, j5) && G.edge(i1, j5)) {
-                        BB = true;
-                    }                             // i1, i2, i3, i4, i5, ii =-= jj, j1
-                    for (int i1 = 0; i1 < n && !BB; i1++) if (i1 != ii && G.edge(i1, jj))
-                    for (int i2 = i1 + 1; i2 < n && !BB; i2++) if (i2 != ii && G.edge(i2, jj))
-                    for (int i3 = i2 + 1; i3 < n && !BB; i3++) if (i3 != ii && G.edge(i3, jj))
-                    for (int i4 = i3 + 1; i4 < n && !BB; i4++) if (i4 != ii && G.edge(i4, jj))
-                    for (int i5 = i4 + 1; i5 < n && !BB; i5++) if (i5 != ii && G.edge(i5, jj))
-                    for (int j1 = 0; j1 < n && !BB; j1++) if (jj != j1 && G.edge(ii, j1) && G.edge(i1, j1) && G.edge(i2, j1) && G.edge(i3, j1) && G.edge(i4, j1) && G.edge(i5, j1)) {
-                        BB = true;
-                    }
-                } else if (graph_name == "K33") { // i1, i2, ii =-= jj, j1, j2
-                    for (int i1 = 0; i1 < n && !BB; i1++) if (i1 != ii && G.edge(i1, jj))
-                    for (int i2 = i1 + 1; i2 < n && !BB; i2++) if (i2 != ii && G.edge(i2, jj))
-                    for (int j1 = 0; j1 < n && !BB; j1++) if (jj != j1 && G.edge(ii, j1) && G.edge(i1, j1) && G.edge(i2, j1))
-                    for (int j2 = j1 + 1; j2 < n && !BB; j2++) if (jj != j2 && G.edge(ii, j2) && G.edge(i1, j2) && G.edge(i2, j2)) {
-                        BB = true;
-                    }
-                } else if (graph_name == "K34") { // i1, i2, ii =-= jj, j1, j2, j3
-                    for (int i1 = 0; i1 < n && !BB; i1++) if (i1 != ii && G.edge(i1, jj))
-                    for (int i2 = i1 + 1; i2 < n && !BB; i2++) if (i2 != ii && G.edge(i2, jj))
-                    for (int j1 = 0; j1 < n && !BB; j1++) if (jj != j1 && G.edge(ii, j1) && G.edge(i1, j1) && G.edge(i2, j1))
-                    for (int j2 = j1 + 1; j2 < n && !BB; j2++) if (jj != j2 && G.edge(ii, j2) && G.edge(i1, j2) && G.edge(i2, j2))
-                    for (int j3 = j2 + 1; j3 < n && !BB; j3++) if (jj != j3 && G.edge(ii, j3) && G.edge(i1, j3) && G.edge(i2, j3)) {
-                        BB = true;
-                    }                             // i1, i2, i3, ii =-= jj, j1, j2
-                    for (int i1 = 0; i1 < n && !BB; i1++) if (i1 != ii && G.edge(i1, jj))
-                    for (int i2 = i1 + 1; i2 < n && !BB; i2++) if (i2 != ii && G.edge(i2, jj))
-                    for (int i3 = i2 + 1; i3 < n && !BB; i3++) if (i3 != ii && G.edge(i3, jj))
-                    for (int j1 = 0; j1 < n && !BB; j1++) if (jj != j1 && G.edge(ii, j1) && G.edge(i1, j1) && G.edge(i2, j1) && G.edge(i3, j1))
-                    for (int j2 = j1 + 1; j2 < n && !BB; j2++) if (jj != j2 && G.edge(ii, j2) && G.edge(i1, j2) && G.edge(i2, j2) && G.edge(i3, j2)) {
-                        BB = true;
-                    }
-                } else if (graph_name == "K35") { // i1, i2, ii =-= jj, j1, j2, j3, j4
-                    for (int i1 = 0; i1 < n && !BB; i1++) if (i1 != ii && G.edge(i1, jj))
-                    for (int i2 = i1 + 1; i2 < n && !BB; i2++) if (i2 != ii && G.edge(i2, jj))
-                    for (int j1 = 0; j1 < n && !BB; j1++) if (jj != j1 && G.edge(ii, j1) && G.edge(i1, j1) && G.edge(i2, j1))
-                    for (int j2 = j1 + 1; j2 < n && !BB; j2++) if (jj != j2 && G.edge(ii, j2) && G.edge(i1, j2) && G.edge(i2, j2))
-                    for (int j3 = j2 + 1; j3 < n && !BB; j3++) if (jj != j3 && G.edge(ii, j3) && G.edge(i1, j3) && G.edge(i2, j3))
-                    for (int j4 = j3 + 1; j4 < n && !BB; j4++) if (jj != j4 && G.edge(ii, j4) && G.edge(i1, j4) && G.edge(i2, j4)) {
-                        BB = true;
-                    }                             // i1, i2, i3, i4, ii =-= jj, j1, j2
-                    for (int i1 = 0; i1 < n && !BB; i1++) if (i1 != ii && G.edge(i1, jj))
-                    for (int i2 = i1 + 1; i2 < n && !BB; i2++) if (i2 != ii && G.edge(i2, jj))
-                    for (int i3 = i2 + 1; i3 < n && !BB; i3++) if (i3 != ii && G.edge(i3, jj))
-                    for (int i4 = i3 + 1; i4 < n && !BB; i4++) if (i4 != ii && G.edge(i4, jj))
-                    for (int j1 = 0; j1 < n && !BB; j1++) if (jj != j1 && G.edge(ii, j1) && G.edge(i1, j1) && G.edge(i2, j1) && G.edge(i3, j1) && G.edge(i4, j1))
-                    for (int j2 = j1 + 1; j2 < n && !BB; j2++) if (jj != j2 && G.edge(ii, j2) && G.edge(i1, j2) && G.edge(i2, j2) && G.edge(i3, j2) && G.edge(i4, j2)) {
-                        BB = true;
-                    }
-                } else if (graph_name == "K36") { // i1, i2, ii =-= jj, j1, j2, j3, j4, j5
-                    for (int i1 = 0; i1 < n && !BB; i1++) if (i1 != ii && G.edge(i1, jj))
-                    for (int i2 = i1 + 1; i2 < n && !BB; i2++) if (i2 != ii && G.edge(i2, jj))
-                    for (int j1 = 0; j1 < n && !BB; j1++) if (jj != j1 && G.edge(ii, j1) && G.edge(i1, j1) && G.edge(i2, j1))
-                    for (int j2 = j1 + 1; j2 < n && !BB; j2++) if (jj != j2 && G.edge(ii, j2) && G.edge(i1, j2) && G.edge(i2, j2))
-                    for (int j3 = j2 + 1; j3 < n && !BB; j3++) if (jj != j3 && G.edge(ii, j3) && G.edge(i1, j3) && G.edge(i2, j3))
-                    for (int j4 = j3 + 1; j4 < n && !BB; j4++) if (jj != j4 && G.edge(ii, j4) && G.edge(i1, j4) && G.edge(i2, j4))
-                    for (int j5 = j4 + 1; j5 < n && !BB; j5++) if (jj != j5 && G.edge(ii, j5) && G.edge(i1, j5) && G.edge(i2, j5)) {
-                        BB = true;
-                    }                             // i1, i2, i3, i4, i5, ii =-= jj, j1, j2
-                    for (int i1 = 0; i1 < n && !BB; i1++) if (i1 != ii && G.edge(i1, jj))
-                    for (int i2 = i1 + 1; i2 < n && !BB; i2++) if (i2 != ii && G.edge(i2, jj))
-                    for (int i3 = i2 + 1; i3 < n && !BB; i3++) if (i3 != ii && G.edge(i3, jj))
-                    for (int i4 = i3 + 1; i4 < n && !BB; i4++) if (i4 != ii && G.edge(i4, jj))
-                    for (int i5 = i4 + 1; i5 < n && !BB; i5++) if (i5 != ii && G.edge(i5, jj))
-                    for (int j1 = 0; j1 < n && !BB; j1++) if (jj != j1 && G.edge(ii, j1) && G.edge(i1, j1) && G.edge(i2, j1) && G.edge(i3, j1) && G.edge(i4, j1) && G.edge(i5, j1))
-                    for (int j2 = j1 + 1; j2 < n && !BB; j2++) if (jj != j2 && G.edge(ii, j2) && G.edge(i1, j2) && G.edge(i2, j2) && G.edge(i3, j2) && G.edge(i4, j2) && G.edge(i5, j2)) {
-                        BB = true;
-                    }
-                } else if (graph_name == "K44") { // i1, i2, i3, ii =-= jj, j1, j2, j3
-                    for (int i1 = 0; i1 < n && !BB; i1++) if (i1 != ii && G.edge(i1, jj))
-                    for (int i2 = i1 + 1; i2 < n && !BB; i2++) if (i2 != ii && G.edge(i2, jj))
-                    for (int i3 = i2 + 1; i3 < n && !BB; i3++) if (i3 != ii && G.edge(i3, jj))
-                    for (int j1 = 0; j1 < n && !BB; j1++) if (jj != j1 && G.edge(ii, j1) && G.edge(i1, j1) && G.edge(i2, j1) && G.edge(i3, j1))
-                    for (int j2 = j1 + 1; j2 < n && !BB; j2++) if (jj != j2 && G.edge(ii, j2) && G.edge(i1, j2) && G.edge(i2, j2) && G.edge(i3, j2))
-                    for (int j3 = j2 + 1; j3 < n && !BB; j3++) if (jj != j3 && G.edge(ii, j3) && G.edge(i1, j3) && G.edge(i2, j3) && G.edge(i3, j3)) {
-                        BB = true;
-                    }
-                } else if (graph_name == "Q3") { // i3 < i1, i2 > ii =-= jj < j1, j2 > j3
-                    for (int i1 = 0; i1 < n && !BB; i1++) if (G.edge(i1, ii))
-                    for (int i2 = i1 + 1; i2 < n && !BB; i2++) if (G.edge(i2, ii))
-                    for (int i3 = 0; i3 < n && !BB; i3++) if (i3 != ii && G.edge(i3, i1) && G.edge(i3, i2))
-                    for (int j1 = 0; j1 < n && !BB; j1++) if (j1 != ii && j1 != i2 && j1 != i3 && G.edge(j1, jj) && G.edge(j1, i1))
-                    for (int j2 = 0; j2 < n && !BB; j2++) if (j2 != ii && j2 != i1 && j2 != i3 && j2 != j1 && G.edge(j2, jj) && G.edge(j2, i2))
-                    for (int j3 = 0; j3 < n && !BB; j3++) if (j3 != ii && j3 != jj && j3 != i1 && j3 != i2 && G.edge(j3, j1) && G.edge(j3, i2) && G.edge(j3, i3)) {
-                        BB = true;
-                    }
-                }
-                G.killEdge(ii, jj);
-                if (!BB) {
+                if (!matcher.existsThrough(G, ii, jj)) {
                     return false;
                 }
             }
@@ -724,59 +274,81 @@ private:
         nextCycle(G, th, 0);
     }
 
-    void getGraphs() {
+    bool getGraphs() {
         for (int n = Hn; n <= N; n++) {
             if (ln[n] > un[n]) {
                 continue;
             }
+            // CR holds the graphs on n vertices and describes them so in the header of Cr(n)
+            CR.resize(n);
+            // Cr(n - 1) is complete only once the graphs queued for it are written,
+            // a file which was not written to is read at once
+            const std::string input_path = address + "Critical/Cr(" + std::to_string(n - 1) + ", " + graph_name + ").gr";
+            if (queued.count(input_path)) {
+                if (!output.wait()) {
+                    std::cout << "Could not write the graphs on " << n - 1 << " vertices" << std::endl;
+                    return false;
+                }
+                queued.clear();
+            }
+            // Cr(n - 1) is read once for every degree d, so it is opened once and its beginning is read
+            // in the background while the cliques are found. The graphs of Cr(n) are written in the background
+            ReadAhead reader({input_path}, n - 1, 1);
+            std::unique_ptr<const GraphFile> file;
 
             for (d = n - 1; d >= dH - 1; --d) {   // adding new vertex of degree  d > 0 // vertex number [n-1]
-                std::fstream stream;
-                stream.open(address + "Critical/Cr(" + std::to_string(n - 1) + ", " + graph_name + ").gr", std::ios::in | std::ios::binary);
                 getCliques(n - 1, d);
-                std::mutex read_mutex;
-                std::vector<std::thread> threads;
-                for (int th = 0; th < num_threads; ++th) {
-                    threads.emplace_back([this, n, th, &stream, &read_mutex] {
-                    Graph G(n - 1);
-                    for (;;) {
-                        read_mutex.lock();
-                        bool end = readGraph(stream, G);
-                        read_mutex.unlock();
-                        if (end == false) {
-                            return;
-                        }
-		                if (G.deg() + 1 < d || G.edges() + d < ln[n]) { //if minimal degree is small enough && there are enough edges
-		                    continue;
-		                }
-                        Graph F = G + 1;
-                        for (const std::vector<size_t>& clique : cliques) {
-                            for (int x : clique) { // adding  a vertex [n-1] of degree d to the clique [i]
-                                F.addEdge(x, n - 1);
+                if (!file) {
+                    file = reader.next();
+                }
+                const GraphFile& input = *file;
+                // the workers take chunks of graphs from a common cursor. Most graphs are filtered
+                // out at once, so the chunks are not made smaller than batch
+                const size_t batch = 64;
+                ChunkCursor cursor(input.count(), pool.size(), batch);
+                TaskPool::Group group(pool);
+                for (size_t t = 0; t < pool.size(); ++t) {
+                    group.run([this, n, &input, &cursor] {
+                    const size_t th = pool.worker();
+                    size_t first, last;
+                    while (cursor.next(first, last)) {
+                        // filtering is done on the raw certificate, a graph is built only if it passes
+                        input.scan(first, last, [&](size_t, const GraphView& G) {
+                            if (G.deg() + 1 < d || G.edges() + d < ln[n]) { //if minimal degree is small enough && there are enough edges
+                                return;
                             }
-                            if (F.deg() >= d) {
-                                getCycles(F, th);
-                                deleteCycles(F, th); // deleting all cycles and adding new critical and extremal graphs
+                            Graph F = Graph(G) + 1;
+                            for (const std::vector<size_t>& clique : cliques) {
+                                for (int x : clique) { // adding  a vertex [n-1] of degree d to the clique [i]
+                                    F.addEdge(x, n - 1);
+                                }
+                                if (F.deg() >= d) {
+                                    getCycles(F, th);
+                                    deleteCycles(F, th); // deleting all cycles and adding new critical and extremal graphs
+                                }
+                                for (int x : clique) { // adding  a vertex [n-1] of degree d to the clique [i]
+                                    F.killEdge(x, n - 1);
+                                } 
                             }
-                            for (int x : clique) { // adding  a vertex [n-1] of degree d to the clique [i]
-                                F.killEdge(x, n - 1);
-                            } 
-                        }
+                        });
                     }
                     });
                 }
-                for (int th = 0; th < num_threads; ++th) {
-                    threads[th].join();
-                }
+                group.wait();
                 
                 //adding new graphs to lists
                 std::string path = address + "Critical/Cr(" + std::to_string(n) + ", " + graph_name + ").gr";
+                if (!CR.empty() && !CR.write(output, path, true)) {
+                    std::cout << "Could not write the graphs on " << n << " vertices" << std::endl;
+                    return false;
+                }
                 if (!CR.empty()) {
-                    CR.write(path, true);
+                    queued.insert(path);
                 }
                 CR.clear();
             }
         }
+        return true;
     }
 
     void getBounds(int k) {
@@ -793,12 +365,18 @@ private:
     }
 
     Graph H;
+    SubgraphMatcher matcher;
     int N;
     int dH, Hn, He;
     int d;
 
     GraphSet CR;
     GraphSet EX;
+    // writes Cr and EX files in the background
+    AsyncWriter output;
+    // the Cr files queued to output since it was waited for
+    std::set<std::string> queued;
+    TaskPool pool;
 
     std::string graph_name;
     std::string address;
@@ -847,7 +425,10 @@ int main(int argc, char** argv) {
 
     for (int n = turan.start();; ++n) {
         std::chrono::time_point<std::chrono::system_clock> start = std::chrono::system_clock::now();
-        const auto [ex, e] = turan.compute(n);
+        int ex, e;
+        if (!turan.compute(n, ex, e)) {
+            return 1;
+        }
         std::chrono::time_point<std::chrono::system_clock> end = std::chrono::system_clock::now();
         std::string result = "ex(" + std::to_string(n) + ", " + graph_name + ") = " + std::to_string(ex) + "/" + std::to_string(e);
         while (result.size() < 32) {
@@ -856,7 +437,11 @@ int main(int argc, char** argv) {
         std::cout << result;
         if (VERBOSE) {
             std::chrono::duration<float> difference = end - start;
-            std::cout << difference.count() << "s";
+            std::cout << difference.count() << "s, busy";
+            for (double busy : turan.busyTimes()) {
+                std::cout << " " << std::round(busy * 1000) / 1000;
+            }
+            std::cout << "s";
         }
         std::cout << std::endl;
     }
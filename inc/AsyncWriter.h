@@ -0,0 +1,89 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// writes files from a background thread. The data is copied into one of two large
+// blocks while the other one is written, so the caller waits only when both are full.
+// A new file is written to path.tmp and renamed to path when it is finished, so a file
+// under its name is always complete; appending writes to the file in place.
+// Several files may be queued one after another, finish() does not wait for the disk.
+// There is one producer: the block being filled is not locked, so only the thread which
+// constructed the writer may call its methods, e.g. not the workers of a TaskPool
+class AsyncWriter {
+public:
+    static const size_t default_block_size = 1 << 20;
+
+    // with sync the files are flushed to the disk by fsync before they are renamed
+    explicit AsyncWriter(bool sync = false, size_t block_size = default_block_size);
+    AsyncWriter(const AsyncWriter&) = delete;
+    AsyncWriter& operator=(const AsyncWriter&) = delete;
+    // writes everything queued
+    ~AsyncWriter();
+
+    // starts the next file, the previous one must be finished
+    void open(const std::string& path, bool append = false);
+    void write(const uint8_t* data, size_t size);
+    // writes data at offset of the file after all of its other data, e.g. a header
+    void patch(uint64_t offset, const uint8_t* data, size_t size);
+    // hands the rest of the file to the background thread
+    void finish();
+    // waits until all queued files are written, returns false if some of them failed
+    bool wait();
+
+private:
+    enum Kind {
+        Open,
+        Append,
+        Data,
+        Patch,
+        Finish
+    };
+
+    struct Task {
+        explicit Task(Kind kind, const std::string& path = "") : kind(kind), path(path) {
+        }
+
+        Kind kind;
+        std::string path;
+        uint64_t offset = 0;
+        std::unique_ptr<std::vector<uint8_t>> data;
+    };
+
+    void push(Task task);
+    void run();
+    // runs a task in the background thread, returns false if it failed
+    bool execute(Task& task);
+
+    bool sync_;
+    size_t block_size_;
+    // the block being filled by the producer
+    std::unique_ptr<std::vector<uint8_t>> block_;
+    std::thread::id producer_;
+
+    std::mutex mut_;
+    std::condition_variable cv_;
+    std::deque<Task> tasks_;
+    // blocks given back by the background thread
+    std::vector<std::unique_ptr<std::vector<uint8_t>>> free_;
+    // the blocks which exist, at most two
+    size_t blocks_;
+    bool busy_;
+    bool failed_;
+    bool stop_;
+
+    // the file of the background thread
+    int fd_;
+    std::string path_;
+    std::string temp_;
+    // some data of the file was not written, so it must not replace the old one
+    bool broken_;
+
+    std::thread thread_;
+};
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+typedef uint64_t word;
+
+// number of 64-bit words needed to store n bits
+inline size_t wordCount(size_t n) {
+    return (n + 63) >> 6;
+}
+
+inline size_t popcount(word w) {
+    return __builtin_popcountll(w);
+}
+
+// a set of integers 0, 1, ..., n - 1 stored as an array of 64-bit words.
+// Methods taking a raw word pointer expect an array of words() words,
+// e.g. a row of the adjacency matrix of a graph
+class Bitset {
+public:
+    Bitset() : n_(0) {
+    }
+
+    explicit Bitset(size_t n) : n_(n), data_(wordCount(n), 0) {
+    }
+
+    size_t size() const {
+        return n_;
+    }
+
+    size_t words() const {
+        return data_.size();
+    }
+
+    word* data() {
+        return data_.data();
+    }
+
+    const word* data() const {
+        return data_.data();
+    }
+
+    void resize(size_t n) {
+        n_ = n;
+        data_.assign(wordCount(n), 0);
+    }
+
+    bool test(size_t i) const {
+        return (data_[i >> 6] >> (i & 63)) & 1;
+    }
+
+    void set(size_t i) {
+        data_[i >> 6] |= word(1) << (i & 63);
+    }
+
+    void reset(size_t i) {
+        data_[i >> 6] &= ~(word(1) << (i & 63));
+    }
+
+    // removes all elements
+    void clear() {
+        for (word& w : data_) {
+            w = 0;
+        }
+    }
+
+    // removes all elements smaller than i
+    void removeBelow(size_t i) {
+        size_t k = std::min(i >> 6, data_.size());
+        for (size_t j = 0; j < k; ++j) {
+            data_[j] = 0;
+        }
+        if (k < data_.size()) {
+            data_[k] &= ~word(0) << (i & 63);
+        }
+    }
+
+    // makes the set equal to {0, 1, ..., n - 1}
+    void fill() {
+        for (word& w : data_) {
+            w = ~word(0);
+        }
+        if (n_ & 63) {
+            data_.back() = (word(1) << (n_ & 63)) - 1;
+        }
+    }
+
+    size_t count() const {
+        size_t c = 0;
+        for (word w : data_) {
+            c += popcount(w);
+        }
+        return c;
+    }
+
+    bool any() const {
+        for (word w : data_) {
+            if (w) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // the smallest element >= i, or size() if there is none
+    size_t next(size_t i) const {
+        if (i >= n_) {
+            return n_;
+        }
+        size_t k = i >> 6;
+        word w = data_[k] & (~word(0) << (i & 63));
+        while (!w) {
+            if (++k >= data_.size()) {
+                return n_;
+            }
+            w = data_[k];
+        }
+        return (k << 6) + __builtin_ctzll(w);
+    }
+
+    size_t first() const {
+        return next(0);
+    }
+
+    void assign(const word* w) {
+        for (size_t k = 0; k < data_.size(); ++k) {
+            data_[k] = w[k];
+        }
+    }
+
+    void intersect(const word* w) {
+        for (size_t k = 0; k < data_.size(); ++k) {
+            data_[k] &= w[k];
+        }
+    }
+
+    void unite(const word* w) {
+        for (size_t k = 0; k < data_.size(); ++k) {
+            data_[k] |= w[k];
+        }
+    }
+
+    void subtract(const word* w) {
+        for (size_t k = 0; k < data_.size(); ++k) {
+            data_[k] &= ~w[k];
+        }
+    }
+
+    Bitset& operator&=(const Bitset& B) {
+        intersect(B.data());
+        return *this;
+    }
+
+    Bitset& operator|=(const Bitset& B) {
+        unite(B.data());
+        return *this;
+    }
+
+    Bitset& operator-=(const Bitset& B) {
+        subtract(B.data());
+        return *this;
+    }
+
+    bool operator==(const Bitset& B) const {
+        return n_ == B.n_ && data_ == B.data_;
+    }
+
+    bool operator!=(const Bitset& B) const {
+        return !(*this == B);
+    }
+
+private:
+    size_t n_;
+    std::vector<word> data_;
+};
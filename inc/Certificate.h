@@ -3,8 +3,13 @@
 #include <cstdint>
 #include <string>
 
+// the canonical code of a structure. Codes of at most inline_size bytes,
+// e.g. of all graphs on up to 23 vertices, are kept inside the object
+// and longer ones on the heap
 class Certificate {
 public:
+    static const size_t inline_size = 32;
+
     Certificate();
     explicit Certificate(size_t m);
     Certificate(const Certificate& cert);
@@ -19,10 +24,18 @@ public:
     uint8_t* data() const;
 
 private:
-    uint16_t size_;
-    uint8_t* data_;
+    bool isInline() const;
+
+    size_t size_;
+    union {
+        uint8_t small_[inline_size];
+        uint8_t* data_;
+    };
 };
 
+// the hash of a certificate given by its bytes
+size_t hashBytes(const uint8_t* data, size_t size);
+
 template<>
 struct std::hash<Certificate> {
     size_t operator()(const Certificate& cert) const;
@@ -31,5 +44,7 @@ struct std::hash<Certificate> {
 std::string CertToString(const Certificate& cert);
 Certificate Cert(const std::string& s);
 
+// the order of sorted files: longer certificates first, then larger bytes first.
+// Returns a negative number if C goes before D, 0 if they are equal
 int compareCertificates(const Certificate& C, const Certificate& D);
 bool operator==(const Certificate& C, const Certificate& D);
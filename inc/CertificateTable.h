@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// a flat open addressing hash set of certificates of one fixed length.
+// The certificates lie one after another in a single arena, a separate array
+// keeps a one-byte fingerprint of every slot (0 for an empty slot),
+// so that a probe looks at the certificate bytes only when the fingerprints match.
+// The caller gives the hash of every certificate, which must be hashBytes of it
+class CertificateTable {
+public:
+    explicit CertificateTable(size_t length = 0);
+
+    size_t length() const;
+    size_t size() const;
+    size_t capacity() const;
+    // bytes allocated by the table
+    size_t memory() const;
+
+    // inserts the certificate and returns true if it was not in the table yet
+    bool insert(const uint8_t* cert, size_t hash);
+    bool contains(const uint8_t* cert, size_t hash) const;
+    void clear();
+
+    // slots for iteration: a slot is either empty or holds a certificate
+    bool occupied(size_t slot) const;
+    const uint8_t* at(size_t slot) const;
+
+private:
+    size_t find(const uint8_t* cert, size_t hash, uint8_t& tag) const;
+    void grow();
+
+    size_t length_;
+    size_t size_;
+    size_t mask_;
+    std::vector<uint8_t> tags_;
+    std::vector<uint8_t> arena_;
+};
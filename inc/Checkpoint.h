@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "AsyncWriter.h"
+
+// the state of a long run saved from time to time, so that the run can be resumed after
+// a crash. It is a text file of lines, each of a tag and some numbers, e.g. the position
+// reached in an input file. The file is replaced at once when it is written again
+class Checkpoint {
+public:
+    // reads the file, the checkpoint is empty if there is none
+    explicit Checkpoint(const std::string& path);
+
+    const std::string& path() const;
+    bool empty() const;
+    // the numbers of all lines of the tag
+    std::vector<std::vector<size_t>> get(const std::string& tag) const;
+    void add(const std::string& tag, const std::vector<size_t>& values);
+    void clear();
+    // queues the file to out, it gets its name when it is complete
+    void write(AsyncWriter& out) const;
+    // removes the file, the run it belongs to is done
+    void remove();
+
+private:
+    std::string path_;
+    std::vector<std::pair<std::string, std::vector<size_t>>> lines_;
+};
+
+// tells the workers when the next checkpoint is due. A worker asks due() between its
+// chunks of work and stops taking chunks once it is true, then the main thread saves
+// the checkpoint and restarts the clock
+class CheckpointClock {
+public:
+    // the seconds between the checkpoints, 0 turns them off
+    explicit CheckpointClock(double seconds);
+
+    bool enabled() const;
+    bool due();
+    // has some worker found the checkpoint due
+    bool paused() const;
+    void restart();
+
+private:
+    std::chrono::steady_clock::duration interval_;
+    std::atomic<std::chrono::steady_clock::rep> deadline_;
+    std::atomic<bool> due_;
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "AsyncWriter.h"
+#include "GrFormat.h"
+#include "MappedFile.h"
+
+// A compressed .gr file keeps the certificates in blocks of block_size ones:
+//   the header with the compressed flag, block_size (4 bytes), the number of blocks (4 bytes),
+//   the position of the index (8 bytes), the blocks, and the index: the position of every
+//   block and of the index itself (8 bytes each) and the first certificate of every block.
+// In a block every certificate after the first one is given by the length p of the prefix
+// it shares with the previous one, the difference of their bytes at p and the remaining bytes.
+// The prefix lengths and the bytes are Huffman coded with two tables stored in the block,
+// no code is longer than 11 bits. The prefix lengths have their own stream, the bytes are cut
+// into four parts with own streams, the sizes of the streams but the last follow the tables.
+// The four parts are decoded side by side, one table lookup gives up to two bytes.
+// Sorted certificates share long prefixes and differ a little at p, so they compress well.
+// Decoding gives about 500 MB/s of certificates on one core (bench_compress), so the format
+// pays off for disks slower than that, not for fast SSDs. Nothing writes it by default,
+// it is made by grtool compress. Certificates of at most 255 bytes are supported.
+// The file is written by an AsyncWriter like a GrWriter, so it appears under its name complete
+class CompressedWriter {
+public:
+    static const size_t default_block_size = 4096;
+
+    CompressedWriter(const std::string& path, const GrHeader& header, size_t block_size = default_block_size);
+    CompressedWriter(const CompressedWriter&) = delete;
+    CompressedWriter& operator=(const CompressedWriter&) = delete;
+    ~CompressedWriter();
+
+    // false if the file could not be written, known after close
+    bool good() const;
+    void add(const uint8_t* cert);
+    size_t count() const;
+    void close();
+
+private:
+    void flush();
+
+    AsyncWriter out_;
+    bool open_;
+    bool good_;
+    GrHeader header_;
+    size_t block_size_;
+    // the certificates of the current block
+    std::vector<uint8_t> block_;
+    std::vector<uint64_t> offsets_;
+    std::vector<uint8_t> firsts_;
+    // the last certificate of the previous block
+    std::vector<uint8_t> last_;
+    uint64_t position_;
+};
+
+// a memory mapped compressed .gr file. Blocks are decoded independently,
+// so the file can be read from any block and by many threads at once
+class CompressedFile {
+public:
+    explicit CompressedFile(const std::string& path);
+
+    bool good() const;
+    const GrHeader& header() const;
+    size_t count() const;
+    size_t length() const;
+    size_t blocks() const;
+    size_t blockSize() const;
+    // the certificates of the block b one after another
+    void decodeBlock(size_t b, std::vector<uint8_t>& out) const;
+    // calls visit(i, cert) for all certificates in the order of the file
+    void scan(const std::function<void(size_t, const uint8_t*)>& visit) const;
+    // binary search over the first certificates of the blocks, then in one block.
+    // False for a file which is not sorted, scan it instead
+    bool contains(const uint8_t* cert) const;
+    // compares the checksum of the certificates with the header, decodes the whole file
+    bool verify() const;
+
+private:
+    MappedFile file_;
+    GrHeader header_;
+    bool good_;
+    size_t block_size_;
+    size_t blocks_;
+    // the positions of the blocks and the first certificates in the index
+    const uint8_t* offsets_;
+    const uint8_t* firsts_;
+};
+
+// compresses a .gr file of graphs on n vertices, headerless or with a header.
+// Returns the number of certificates written. good is set to false if the input can not be
+// read or the output can not be written, the old output is kept then
+size_t compressGr(const std::string& input, const std::string& output, size_t n, bool* good = nullptr);
+// writes a compressed file as a .gr file with a header, good is set as by compressGr
+size_t decompressGr(const std::string& input, const std::string& output, bool* good = nullptr);
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "Bitset.h"
+#include "Graph.h"
+#include "Matcher.h"
+
+// class generating all feasible cones for the one-vertex extension,
+// i.e. sets of d vertices of H such that joining a new vertex to them
+// creates no copy of the forbidden graph.
+// The cones are enumerated by a bitset search: the candidates of the next vertex
+// lose every vertex completing a forbidden set of H with the vertices chosen so far.
+// A worker keeps one generator and resets it for every graph, which reuses its buffers
+class ConeGenerator {
+public:
+    ConeGenerator();
+    ConeGenerator(const Graph& H, const SubgraphMatcher& M);
+
+    // prepares the search of the cones of H
+    void reset(const Graph& H, const SubgraphMatcher& M);
+    // can the new vertex be isolated
+    bool isolated() const;
+    // calls visit for all cones of min_deg to max_deg vertices in one search. A subset of a cone
+    // is a cone, so every cone is met on the way to the larger ones. The cones of one size
+    // come in lexicographic order
+    void visitCones(size_t min_deg, size_t max_deg, const std::function<void(const std::vector<size_t>&)>& visit);
+
+private:
+    void next(size_t l);
+    // the length of the pattern of M if it is a cycle of 3 to 5 vertices, otherwise 0
+    static size_t shortCycle(const SubgraphMatcher& M);
+
+    size_t min_deg;
+    size_t d;
+    size_t n;
+    bool blocked;
+    Bitset excluded;
+    std::vector<Bitset> conflicts;
+    // the forbidden sets of 3 vertices: the vertices z with {x, y, z} forbidden are pairs[x * n + y],
+    // for the forbidden graph K4 this is the common neighbourhood of the edge xy
+    std::vector<Bitset> pairs;
+    std::vector<size_t> touched;
+    // the larger forbidden sets one after the other, the set i lies in [starts[i], starts[i + 1])
+    std::vector<size_t> sets;
+    std::vector<size_t> starts;
+    std::vector<std::vector<size_t>> larger;
+    Bitset chosen;
+    std::vector<Bitset> candidates;
+    std::vector<size_t> cone;
+    const std::function<void(const std::vector<size_t>&)>* visit;
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "Graph.h"
+#include "MappedFile.h"
+
+// a set of graphs on n vertices which is not bounded by the memory.
+// Certificates are collected in a flat GraphSet until it takes about budget bytes,
+// then they are sorted and spilled to a run file prefix.runK. K counts up, so the runs
+// are numbered in a row and a merged run gets a new name. A graph is inserted
+// only if no run contains it, so the runs are disjoint and size() is exact.
+// write merges the runs and the buffer into one sorted .gr file with a header.
+// The run files are internal and headerless.
+// With budget 0 the set never spills and works as a flat GraphSet
+class ExternalGraphSet {
+public:
+    // with sync the run files are flushed to the disk by fsync before they are used
+    ExternalGraphSet(size_t n, size_t budget = 0, const std::string& prefix = "", bool sync = false);
+    ExternalGraphSet(const ExternalGraphSet&) = delete;
+    ExternalGraphSet& operator=(const ExternalGraphSet&) = delete;
+    ~ExternalGraphSet();
+
+    void insert(const Graph& G);
+    // inserts G and returns true if it was not in the set yet
+    bool insertIfAbsent(const Graph& G);
+    bool contains(const Graph& G) const;
+    size_t size() const;
+    bool empty() const;
+    // the number of run files spilled so far
+    size_t runs() const;
+    // false once a run file could not be written. The set then keeps the rest
+    // in memory and does not spill anymore, and its checkpoints are not valid
+    bool good() const;
+    // spills the buffer even if it is small, so that the whole set is kept by the run files
+    // prefix.run<first> ... and survives the process. More than max_runs runs are merged into
+    // a new one, the runs merged stay on the disk until committed, so that the checkpoint saved
+    // before stays valid until the new one is saved. Returns the number of runs
+    size_t checkpoint(size_t& first);
+    // the checkpoint is saved on the disk: removes the run files merged away
+    void committed();
+    // takes the runs run files from first on of a set of the same prefix left by a process which
+    // ended without clearing it, after its checkpoint. The run files spilled or merged after the
+    // checkpoint and those merged away before it are removed.
+    // The set must be empty. Returns false if a run file is missing or damaged
+    bool restore(size_t first, size_t runs);
+    void write(const std::string& path) const;
+    // queues the merged file to out, the runs are read before write returns
+    void write(AsyncWriter& out, const std::string& path) const;
+    // empties the set and removes the run files
+    void clear();
+
+private:
+    // a sorted run on the disk. The first certificate of every block of
+    // index_step ones is kept in memory, so that a lookup reads one block
+    struct Run {
+        std::string path;
+        MappedFile file;
+        size_t count;
+        std::vector<uint8_t> index;
+    };
+
+    static const size_t index_step = 64;
+    // the runs left by a checkpoint, a lookup reads a block of every run
+    static const size_t max_runs = 8;
+
+    bool inRuns(const uint8_t* cert) const;
+    bool inRun(const Run& run, const uint8_t* cert) const;
+    // the following are called with the exclusive lock
+    bool spill();
+    // merges all runs into a new run, the runs stay as they are if it fails
+    bool mergeRuns();
+    // writes the certificates given by produce to the run file and maps it. A failed file is removed
+    bool writeRun(Run& run, const std::function<void(const std::function<void(const uint8_t*)>&)>& produce) const;
+    // calls visit for the certificates of list and the runs in the order of compareCertificates,
+    // every one once. list is sorted as by GraphSet::getSorted
+    void merge(const std::vector<const uint8_t*>& list, const std::function<void(const uint8_t*)>& visit) const;
+    // maps the run file of a restored set and builds its index
+    bool openRun(Run& run);
+
+    size_t n;
+    size_t length_;
+    // the number of buffered certificates making the spill
+    size_t limit_;
+    std::string prefix_;
+    bool sync_;
+    bool good_;
+    GraphSet buffer_;
+    std::atomic<size_t> buffered_;
+    std::vector<Run> runs_;
+    // the number of the next run file
+    size_t next_run_;
+    // the run files merged away, removed once the checkpoint after the merge is saved
+    std::vector<std::string> retired_;
+    // inserts share it, a spill takes it exclusively
+    mutable std::shared_mutex mut_;
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "AsyncWriter.h"
+
+// the header of a .gr file, 32 bytes in little endian:
+//   magic "GRF\x1a", version (2 bytes), structure type, flags (bit 0: sorted, bit 1: compressed),
+//   n (4 bytes), certificate length (4 bytes), count (8 bytes), checksum (8 bytes).
+// Older files are headerless, i.e. just the certificates one after another,
+// and are still read when the caller knows the certificate length.
+// The layout of compressed files is described in CompressedFile.h
+struct GrHeader {
+    static const size_t size = 32;
+    static const uint16_t current_version = 1;
+
+    enum Type : uint8_t {
+        unknown = 0,
+        graph = 1
+    };
+
+    uint16_t version = current_version;
+    uint8_t type = unknown;
+    bool sorted = false;
+    bool compressed = false;
+    uint32_t n = 0;
+    uint32_t length = 0;
+    uint64_t count = 0;
+    // the sum of certificateChecksum over all certificates
+    uint64_t checksum = 0;
+
+    void encode(uint8_t* out) const;
+    // does a file of file_size bytes starting with data begin with a header: the magic, a known
+    // version, type and flags, and a certificate length fitting the size of an uncompressed file.
+    // A headerless file whose first certificate begins with the magic is not taken for one
+    static bool present(const uint8_t* data, size_t file_size);
+    // reads the header, returns false if it is damaged or does not match the file size.
+    // The size of a compressed file is checked by CompressedFile
+    bool decode(const uint8_t* data, size_t file_size);
+};
+
+// little endian fields of the headers
+void putLE(uint8_t* out, uint64_t value, size_t bytes);
+uint64_t getLE(const uint8_t* data, size_t bytes);
+
+// the 64-bit FNV-1a hash of a certificate, part of the format. The checksum of a file
+// is the sum of these modulo 2^64, so it does not depend on the order
+uint64_t certificateChecksum(const uint8_t* cert, size_t length);
+
+// writes certificates of one length to a .gr file, the count and the checksum
+// of the header are written by close. In the append mode the certificates are
+// added to an existing file, a headerless one stays headerless. A file with a header
+// which does not fit, e.g. a compressed one or one of another type, n or certificate length,
+// is refused: nothing is written and good() is false. A headerless writer takes the header it finds.
+// So is appending after a failure of a file queued to the same writer.
+// The file is written by an AsyncWriter, a new file appears under its name complete
+class GrWriter {
+public:
+    GrWriter(const std::string& path, const GrHeader& header, bool append = false);
+    // writes a headerless file
+    GrWriter(const std::string& path, size_t length, bool append = false);
+    // the file is queued to the writer out and close does not wait for it
+    GrWriter(AsyncWriter& out, const std::string& path, const GrHeader& header, bool append = false);
+    GrWriter(const GrWriter&) = delete;
+    GrWriter& operator=(const GrWriter&) = delete;
+    ~GrWriter();
+
+    // false if the file could not be written, known after close for an own writer
+    bool good() const;
+    void add(const uint8_t* cert);
+    // the number of certificates in the file
+    size_t count() const;
+    void close();
+
+private:
+    void open(const std::string& path, bool append);
+
+    std::unique_ptr<AsyncWriter> own_;
+    AsyncWriter* out_;
+    bool open_;
+    bool good_;
+    GrHeader header_;
+    bool headerless_;
+};
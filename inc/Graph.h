@@ -1,6 +1,10 @@
 #pragma once
 
+#include <algorithm>
+#include <cstring>
+
 #include "Structure.h"
+#include "GraphView.h"
 
 // a class representing simple graph
 class Graph : public Structure {
@@ -8,14 +12,28 @@ public:
     Graph();
     explicit Graph(size_t n);
     Graph(size_t n, const Certificate& cert);
+    explicit Graph(const GraphView& V);
 
     size_t edges() const;
     bool edge(size_t i, size_t j) const;
+    const word* row(size_t i) const;
+    size_t words() const;
+    size_t degree(size_t i) const;
     size_t deg() const;
     void clear();
     bool subClique(size_t k) const;
+    // is there an independent set of k vertices containing v. If G - v has none,
+    // this tells whether G has one, and only the non-neighbours of v are searched
+    bool hasIndependentSetThrough(size_t v, size_t k) const;
+    // the matrix telling for x != y whether a path of k edges with distinct vertices joins them,
+    // for k = 1, 2 or 3, in the layout of row(): row x lies in the words [x * words(), (x + 1) * words()).
+    // For other k the matrix is empty
+    std::vector<word> pathMatrix(size_t k) const;
     void resize(size_t m);
     std::vector<size_t> getDegrees() const;
+    // colors of the vertices after refining degrees by neighbour colors until stable.
+    // Vertices in one orbit of Aut(G) have equal colors
+    std::vector<size_t> colorClasses() const;
     void addEdge(size_t i, size_t j);
     void killEdge(size_t i, size_t j);
 
@@ -28,7 +46,11 @@ public:
 protected:
     size_t e;
     std::vector<byte> A;
+    // the adjacency matrix once more as bitsets, words_ words per row
+    size_t words_;
+    std::vector<word> R;
     bool nextS(int level, Perm& Q) const;
+    bool nextIndependent(word* C, size_t k) const;
 
     virtual size_t degsize() const override;
     virtual int color(size_t i, size_t j) const override;
@@ -48,64 +70,158 @@ Graph K(size_t n, size_t m);
 Graph C(size_t n);
 Graph P(size_t n);
 Graph Q(size_t n);
+Graph W(size_t n);
 
 // a class for a collection of pairwise non-isomorphic
 // simple graphs of same size
 class GraphSet : public StructSet {
 public:
     GraphSet() = default;
-    GraphSet(size_t n) : n(n) {
+    // with flat set the certificates are kept in flat tables, see StructSet
+    GraphSet(size_t n, bool flat = false) : StructSet(flat ? Graph::certSize(n) : 0), n(n) {
     }
 
     void resize(int m) {
         n = m;
+        if (length_) {
+            reset(Graph::certSize(m));
+        }
     }
 
     std::vector<Certificate> getList() const {
-        return std::vector<Certificate>(data_.begin(), data_.end());
+        std::vector<Certificate> list;
+        for (const Shard& sh : shards_) {
+            list.insert(list.end(), sh.data.begin(), sh.data.end());
+            for (size_t i = 0; i < sh.table.capacity(); i++) {
+                if (sh.table.occupied(i)) {
+                    Certificate cert(length_);
+                    std::copy(sh.table.at(i), sh.table.at(i) + length_, cert.data());
+                    list.push_back(std::move(cert));
+                }
+            }
+        }
+        return list;
+    }
+
+    // pointers to the certificates in the order of compareCertificates. Nothing is copied,
+    // the pointers lead into the sets and tables of the shards. The set must not change meanwhile
+    std::vector<const uint8_t*> getSorted() const {
+        std::vector<const uint8_t*> list;
+        for (const Shard& sh : shards_) {
+            for (const Certificate& cert : sh.data) {
+                list.push_back(cert.data());
+            }
+            for (size_t i = 0; i < sh.table.capacity(); i++) {
+                if (sh.table.occupied(i)) {
+                    list.push_back(sh.table.at(i));
+                }
+            }
+        }
+        // all certificates have one length, larger bytes go first
+        size_t length = Graph::certSize(n);
+        std::sort(list.begin(), list.end(), [length](const uint8_t* a, const uint8_t* b) {
+            return std::memcmp(a, b, length) > 0;
+        });
+        return list;
     }
 
+    // iterates over the shards one after another, in every shard over the node based set
+    // and then over the slots of the flat table. The set must not change meanwhile
     class iterator {
     public:
-        iterator(const GraphSet* gset, const std::unordered_set<Certificate>::const_iterator& it) : gset_(gset), it_(it) {
+        iterator(const GraphSet* gset, size_t shard, const std::unordered_set<Certificate>::const_iterator& it, size_t slot) :
+            gset_(gset), shard_(shard), it_(it), slot_(slot) {
+            skip();
         }
 
         Graph operator*() const {
-            return Graph(gset_->n, *it_);
+            if (it_ != gset_->shards_[shard_].data.end()) {
+                return Graph(gset_->n, *it_);
+            }
+            Certificate cert(gset_->length_);
+            std::copy(data(), data() + gset_->length_, cert.data());
+            return Graph(gset_->n, cert);
+        }
+
+        // access to the graph without decoding its certificate
+        GraphView view() const {
+            return GraphView(gset_->n, data());
         }
 
         bool operator!=(const iterator& it) {
-            return gset_ != it.gset_ || it_ != it.it_;
+            return !(*this == it);
         }
 
         bool operator==(const iterator& it) {
-            return gset_ == it.gset_ && it_ == it.it_;
+            return gset_ == it.gset_ && shard_ == it.shard_ && it_ == it.it_ && slot_ == it.slot_;
         }
 
         iterator& operator++() {
-            ++it_;
+            if (it_ != gset_->shards_[shard_].data.end()) {
+                ++it_;
+            } else {
+                ++slot_;
+            }
+            skip();
             return *this;
         }
 
         iterator operator++(int) {
             iterator it = *this;
-            ++it_;
+            ++*this;
             return it;
         }
 
     private:
+        const uint8_t* data() const {
+            if (it_ != gset_->shards_[shard_].data.end()) {
+                return it_->data();
+            }
+            return gset_->shards_[shard_].table.at(slot_);
+        }
+
+        // moves to the next certificate, the end of the last shard is the end of the set
+        void skip() {
+            while (true) {
+                const Shard& sh = gset_->shards_[shard_];
+                if (it_ != sh.data.end()) {
+                    return;
+                }
+                while (slot_ < sh.table.capacity() && !sh.table.occupied(slot_)) {
+                    ++slot_;
+                }
+                if (slot_ < sh.table.capacity() || shard_ + 1 == num_shards) {
+                    return;
+                }
+                ++shard_;
+                it_ = gset_->shards_[shard_].data.begin();
+                slot_ = 0;
+            }
+        }
+
         const GraphSet* gset_;
+        size_t shard_;
         std::unordered_set<Certificate>::const_iterator it_;
+        size_t slot_;
     };
 
     iterator begin() const {
-        return iterator(this, data_.begin());
+        return iterator(this, 0, shards_[0].data.begin(), 0);
     }
 
     iterator end() const {
-        return iterator(this, data_.end());
+        const Shard& last = shards_[num_shards - 1];
+        return iterator(this, num_shards - 1, last.data.end(), last.table.capacity());
+    }
+
+protected:
+    bool describe(GrHeader& header) const override {
+        header.type = GrHeader::graph;
+        header.n = n;
+        header.length = Graph::certSize(n);
+        return true;
     }
 
 private:
-    size_t n;
+    size_t n = 0;
 };
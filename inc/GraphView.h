@@ -0,0 +1,66 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <string>
+
+#include "Bitset.h"
+#include "GrFormat.h"
+#include "MappedFile.h"
+
+// a read-only view of a simple graph on n vertices given by its packed certificate,
+// i.e. the upper triangle of the adjacency matrix written row by row, 8 bits per byte.
+// The view does not own the bytes, so they must outlive it
+class GraphView {
+public:
+    GraphView(size_t n, const uint8_t* data);
+
+    size_t size() const;
+    const uint8_t* data() const;
+    bool edge(size_t i, size_t j) const;
+    size_t edges() const;
+    size_t degree(size_t i) const;
+    size_t deg() const;
+    std::vector<size_t> getDegrees() const;
+    Bitset neighborhood(size_t i) const;
+
+private:
+    size_t n;
+    const uint8_t* data_;
+};
+
+// a memory-mapped .gr file seen as an array of graphs on n vertices.
+// Threads may read it at once, every one its own range of indices.
+// A file with a header is good if it holds graphs on n vertices and is not
+// truncated, a headerless one if its size is a multiple of the certificate length
+class GraphFile {
+public:
+    GraphFile(const std::string& path, size_t n);
+
+    bool good() const;
+    size_t count() const;
+    // is the file marked as sorted by compareCertificates in its header
+    bool sorted() const;
+    // compares the checksum of the certificates with the header, reads the whole file
+    bool verify() const;
+    GraphView operator[](size_t i) const;
+    // the packed certificate of the i-th graph
+    const uint8_t* certificate(size_t i) const;
+    // calls visit(i, G) for the graphs first..last-1 in batches,
+    // the kernel is asked to read the next batch while the current one is visited
+    void scan(size_t first, size_t last, const std::function<void(size_t, const GraphView&)>& visit) const;
+    // brings the first bytes of the file into the page cache, the whole file by default,
+    // so that the first calls of scan do not wait for the disk
+    void load(size_t bytes = SIZE_MAX) const;
+
+private:
+    MappedFile file_;
+    size_t n;
+    size_t l;
+    bool good_;
+    bool has_header_;
+    GrHeader header_;
+    // the position of the first certificate in the file
+    size_t offset_;
+    size_t count_;
+};
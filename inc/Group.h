@@ -1,6 +1,7 @@
 #pragma once
 #include <cinttypes>
 #include <memory>
+#include <vector>
 
 #include "Permutation.h"
 
@@ -21,6 +22,9 @@ public:
 
     PermList getElements() const;
     PermList getGenerators() const;
+    std::vector<size_t> orbit(size_t v) const;
+    std::vector<std::vector<size_t>> orbit(const std::vector<size_t>& S) const;
+    Group stabilizer(size_t v) const;
 
     bool operator<=(const Group& G) const;
     bool operator>=(const Group& G) const;
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// a read-only memory mapping of a whole file. The file may be larger than the memory,
+// its pages are read on demand and dropped by the kernel when memory is short
+class MappedFile {
+public:
+    MappedFile();
+    explicit MappedFile(const std::string& path);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile&& file);
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&& file);
+    ~MappedFile();
+
+    bool open(const std::string& path);
+    void close();
+    bool good() const;
+    const uint8_t* data() const;
+    size_t size() const;
+    // hints to the kernel, a range needs not be aligned to pages.
+    // The mapping is going to be read from the beginning to the end
+    void adviseSequential() const;
+    // the range is going to be read soon and may be read ahead
+    void prefetch(size_t offset, size_t length) const;
+
+private:
+    uint8_t* data_;
+    size_t size_;
+    bool good_;
+};
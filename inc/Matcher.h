@@ -0,0 +1,65 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "Graph.h"
+
+// a class searching for copies of a small pattern graph P in a host graph G,
+// i.e. for injective maps g from the vertices of P to the vertices of G
+// taking edges to edges (not necessarily induced).
+// The pattern is compiled into search plans once: the order in which pattern
+// vertices are mapped, their earlier neighbours, whose images give a bitset of
+// candidates, and symmetry breaking conditions g(a) < g(b) derived from Aut(P),
+// so that every copy of P is met by the search only once
+class SubgraphMatcher {
+public:
+    SubgraphMatcher();
+    explicit SubgraphMatcher(const Graph& P);
+
+    size_t size() const;
+    const Graph& pattern() const;
+    // is there a copy of P in G
+    bool exists(const Graph& G) const;
+    // is there a copy of P in G + uv using the edge uv, where uv is a non-edge of G
+    bool existsThrough(const Graph& G, size_t u, size_t v) const;
+    // calls visit(g) for every copy of P in G containing the vertex v,
+    // where g[i] is the image of the pattern vertex i. Every copy is visited once.
+    // The enumeration stops as soon as visit returns false
+    void enumerate(const Graph& G, size_t v, const std::function<bool(const std::vector<size_t>&)>& visit) const;
+    // all sets S of vertices of G such that joining a new vertex to the vertices of S
+    // creates a copy of P through the new vertex. The sets are sorted and pairwise distinct
+    std::vector<std::vector<size_t>> forbiddenSets(const Graph& G) const;
+    // calls visit(S) for the same sets S without storing them. S is sorted, but a set
+    // may be visited more than once
+    void visitForbiddenSets(const Graph& G, const std::function<void(const std::vector<size_t>&)>& visit) const;
+
+private:
+    struct Plan {
+        // pattern vertices in the order they are mapped, the first fixed ones are given
+        std::vector<size_t> order;
+        size_t fixed;
+        // for every level the earlier levels adjacent to it in the pattern
+        std::vector<std::vector<size_t>> adjacent;
+        // for every level the earlier levels whose images must be smaller
+        std::vector<std::vector<size_t>> above;
+        // pattern degree of every level
+        std::vector<size_t> degree;
+    };
+
+    Plan makePlan(const std::vector<size_t>& fixed, Group A, bool outside) const;
+    bool search(const Plan& plan, const Graph& G, std::vector<size_t>& g,
+                const std::function<bool(const std::vector<size_t>&)>* visit) const;
+    bool extend(const Plan& plan, const Graph& G, size_t level, std::vector<size_t>& g, word* cand, word* used,
+                const std::function<bool(const std::vector<size_t>&)>* visit) const;
+
+    Graph P;
+    // a plan mapping every vertex freely
+    Plan global;
+    // plans starting with a representative of each vertex orbit of Aut(P)
+    std::vector<Plan> vertex;
+    // plans starting with a representative (a, b) of each orbit of Aut(P) on ordered edges
+    std::vector<Plan> arc;
+    // the same plans as in vertex, but the first vertex is left outside the host graph
+    std::vector<Plan> cone;
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GraphView.h"
+
+// the generators run as a pipeline of three stages: ReadAhead reads the beginning of the
+// next parent files in a background thread, the workers of a TaskPool extend the graphs and an
+// AsyncWriter writes the output files. The stages are joined by bounded queues, so
+// a fast stage waits for a slow one instead of filling the memory
+
+// a bounded queue of one producer and one consumer without locks.
+// push waits while the queue is full and pop while it is empty.
+// Either side may close the queue: pop returns false once the queue is closed
+// and empty, push returns false once it is closed
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : slots_(capacity + 1), head_(0), tail_(0), closed_(false) {
+    }
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    bool push(T value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t next = (tail + 1) % slots_.size();
+        for (size_t spins = 0; next == head_.load(std::memory_order_acquire); spins++) {
+            if (closed_.load(std::memory_order_acquire)) {
+                return false;
+            }
+            pause(spins);
+        }
+        if (closed_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        slots_[tail] = std::move(value);
+        tail_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& value) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        for (size_t spins = 0; head == tail_.load(std::memory_order_acquire); spins++) {
+            // the last value is pushed before the queue is closed
+            if (closed_.load(std::memory_order_acquire) && head == tail_.load(std::memory_order_acquire)) {
+                return false;
+            }
+            pause(spins);
+        }
+        value = std::move(slots_[head]);
+        head_.store((head + 1) % slots_.size(), std::memory_order_release);
+        return true;
+    }
+
+    void close() {
+        closed_.store(true, std::memory_order_release);
+    }
+
+private:
+    // a short wait is spun, a long one sleeps longer and longer up to a millisecond,
+    // so that the other stages get the processor
+    static void pause(size_t spins) {
+        if (spins < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(std::min<size_t>(1000, 10 << std::min<size_t>(spins - 64, 7))));
+        }
+    }
+
+    std::vector<T> slots_;
+    std::atomic<size_t> head_;
+    std::atomic<size_t> tail_;
+    std::atomic<bool> closed_;
+};
+
+// the reader stage: opens the files of graphs on n vertices one after another in a
+// background thread and brings the first window bytes of each into the page cache, at
+// most ahead files before the consumer. So no more than ahead * window bytes are read
+// before they are needed, which for files larger than the memory would push out pages
+// still in use; the rest of a file is read as it is scanned.
+// Files which can not be read are handed out as well, with good() false
+class ReadAhead {
+public:
+    static const size_t default_window = 16 << 20;
+
+    ReadAhead(const std::vector<std::string>& paths, size_t n, size_t ahead = 2, size_t window = default_window);
+    ReadAhead(const ReadAhead&) = delete;
+    ReadAhead& operator=(const ReadAhead&) = delete;
+    // stops the reader, the files not taken are closed
+    ~ReadAhead();
+
+    // the next file in the order of paths, nullptr after the last one
+    std::unique_ptr<const GraphFile> next();
+
+private:
+    BoundedQueue<std::unique_ptr<const GraphFile>> queue_;
+    std::thread thread_;
+};
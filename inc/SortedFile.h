@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "Structure.h"
+
+// a memory mapped file of certificates of one length sorted by compareCertificates,
+// as written by StructSet::writeSorted. Membership is answered by binary search.
+// The file may have a .gr header, which must agree with the length. A file which is
+// not sorted, e.g. the output of a generator, is read but not searched
+class SortedFile {
+public:
+    SortedFile(const std::string& path, size_t length);
+
+    bool good() const;
+    bool hasHeader() const;
+    const GrHeader& header() const;
+    size_t size() const;
+    size_t length() const;
+    const uint8_t* at(size_t i) const;
+    // false if the file is not sorted
+    bool contains(const uint8_t* cert) const;
+    bool contains(const Structure& s) const;
+    // is every certificate before the next one
+    bool isSorted() const;
+    // is the file marked as sorted in its header or found to be sorted by isSorted
+    bool sorted() const;
+
+private:
+    MappedFile file_;
+    size_t length_;
+    size_t count_;
+    bool good_;
+    bool has_header_;
+    bool sorted_;
+    GrHeader header_;
+    // the first certificate
+    const uint8_t* data_;
+};
+
+// streaming set operations over sorted files of certificates of one length.
+// The inputs are read once from the beginning to the end. The output is sorted and has
+// no repeated certificates, it gets the header of the first input, if it has one.
+// It is written to output.tmp and renamed when complete, so it may be one of the inputs.
+// They return the number of certificates written. good is set to false if an input
+// can not be read or is not sorted, or the output can not be written, the old output is kept then
+size_t mergeSorted(const std::vector<std::string>& inputs, const std::string& output, size_t length, bool* good = nullptr);
+// the certificates of a which are not in b
+size_t differenceSorted(const std::string& a, const std::string& b, const std::string& output, size_t length, bool* good = nullptr);
+size_t intersectSorted(const std::string& a, const std::string& b, const std::string& output, size_t length, bool* good = nullptr);
+
+// sorts the graphs of a .gr file of graphs on n vertices into a file with a header,
+// returns their number. good is set as by mergeSorted
+size_t sortFile(const std::string& input, const std::string& output, size_t n, bool* good = nullptr);
+// merges every file of graphs on n vertices in the shard directories with the files of the
+// same name in the other shards and in dir into one sorted file in dir, without repeated graphs.
+// Unsorted parts, e.g. of the canonical mode, are sorted first. Returns the number of graphs
+// in the merged files. good is set to false if a shard directory can not be read or a file
+// can not be sorted or written, the merging stops then and the file being merged is kept
+size_t mergeShards(const std::string& dir, const std::vector<std::string>& shards, size_t n, bool* good = nullptr);
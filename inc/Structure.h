@@ -7,10 +7,13 @@
 #include <string>
 #include <memory>
 #include <list>
+#include <array>
 #include <mutex>
 
 #include "Group.h"
 #include "Certificate.h"
+#include "CertificateTable.h"
+#include "GrFormat.h"
 
 typedef uint8_t byte;
 typedef std::vector<int> Degree;
@@ -40,6 +43,13 @@ public:
     size_t size() const;
     Structure& certify();
     Group aut();
+    const Certificate& certificate() const;
+    // canonical labeling: C[i] is the element put at the position i of the certificate
+    Perm canonicalLabeling();
+    // canonical construction path test for a structure built by adding the element v.
+    // The extension is accepted iff v lies in the orbit of the eligible element coming last
+    // in the canonical labeling. The set of eligible elements must be invariant under Aut
+    bool isCanonicalAugmentation(size_t v, const std::vector<size_t>& eligible);
 
     static void writeStruct(std::fstream&, const Certificate& cert);
     static void readStruct(std::fstream&, Certificate& cert);
@@ -54,6 +64,7 @@ protected:
 
     size_t n;
     Certificate cert;
+    Perm canon;
     std::shared_ptr<Group> auto_group;
 };
 
@@ -107,16 +118,53 @@ private:
 };
 
 // class modelling an unordered collection of non-isomorphic structures. 
+// The certificates are spread over shards by their hash, every shard has its own lock,
+// so that threads inserting different structures rarely wait for each other.
+// If all certificates have one length, it may be given to keep them in flat tables
 class StructSet {
 public:
+    explicit StructSet(size_t length = 0);
+    virtual ~StructSet() = default;
     void insert(const Structure& s);
+    // inserts s and returns true if it was not in the set yet. With flat tables
+    // a certificate of another length is rejected, e.g. of an uncertified structure
+    bool insertIfAbsent(const Structure& s);
     size_t size() const;
     bool empty() const;
-    void write(const std::string& path, bool append = false) const;
+    // writes the certificates with a .gr header if the set can describe them,
+    // otherwise one after another. Appending to a file with a header updates it.
+    // Returns false if the file could not be written or appended to
+    bool write(const std::string& path, bool append = false) const;
+    // queues the file to out, called by the thread owning out, see AsyncWriter. The set may be
+    // changed once write returns. Returns false if the file is refused at once, e.g. after
+    // a failure of a queued file, otherwise out.wait() tells
+    bool write(AsyncWriter& out, const std::string& path, bool append = false) const;
+    // writes the certificates in the order of compareCertificates,
+    // so that the file can be searched and merged, see SortedFile.
+    // The set must not change meanwhile
+    bool writeSorted(const std::string& path) const;
     void clear();
     bool contains(const Structure& s) const;
 
 protected:
-    std::unordered_set<Certificate> data_;
-    mutable std::mutex mut_;
+    static const size_t num_shards = 64;
+
+    struct Shard {
+        std::unordered_set<Certificate> data;
+        CertificateTable table;
+        mutable std::mutex mut;
+    };
+
+    static size_t shardIndex(size_t hash);
+    // fills in the structure type, n and the certificate length of the header.
+    // Returns false if the certificates are not known to be alike
+    virtual bool describe(GrHeader& header) const;
+    // with out == nullptr the file is written before the call returns
+    bool writeFile(AsyncWriter* out, const std::string& path, bool append, bool sorted) const;
+    // empties the set and sets the length of certificates, 0 if it may vary
+    void reset(size_t length);
+
+    // the length of all certificates for the flat tables, or 0 if the node based sets are used
+    size_t length_;
+    std::array<Shard, num_shards> shards_;
 };
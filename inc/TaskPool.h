@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// a fixed set of worker threads running tasks. Every worker keeps its own deque:
+// it takes the newest task of its deque and, when the deque is empty, steals the
+// oldest task of another worker. Tasks are submitted through a Group, which waits
+// for its tasks. A task may create groups and wait for them, the waiting worker
+// runs other tasks meanwhile, so state kept per worker must not live across a wait
+class TaskPool {
+public:
+    class Group {
+    public:
+        explicit Group(TaskPool& pool);
+        Group(const Group&) = delete;
+        Group& operator=(const Group&) = delete;
+        // waits for the tasks
+        ~Group();
+
+        void run(std::function<void()> task);
+        // returns when all tasks of the group are done
+        void wait();
+
+    private:
+        friend class TaskPool;
+
+        TaskPool& pool_;
+        std::atomic<size_t> pending_;
+    };
+
+    explicit TaskPool(size_t threads);
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+    ~TaskPool();
+
+    size_t size() const;
+    // the index of the worker running the caller, size() outside of the pool
+    size_t worker() const;
+    // the seconds every worker spent in tasks since the last reset
+    std::vector<double> busyTimes() const;
+    void resetBusyTimes();
+
+private:
+    struct Task {
+        std::function<void()> run;
+        Group* group;
+    };
+
+    struct Worker {
+        std::mutex mut;
+        std::deque<Task> tasks;
+        // nanoseconds in tasks, a nested task is counted within the task waiting for it
+        std::atomic<uint64_t> busy{0};
+    };
+
+    void push(Task task);
+    // runs one task of the worker index or stolen from another one, false if there was none
+    bool runOne(size_t index);
+    void loop(size_t index);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+    // submissions from outside of the pool go to the workers in turn
+    std::atomic<size_t> next_;
+    std::atomic<size_t> queued_;
+    std::mutex mut_;
+    std::condition_variable cv_;
+    bool stop_;
+};
+
+// hands out chunks of the indices [0, count) to the workers. A chunk is the
+// remaining range divided by twice the number of workers, but at least min_chunk,
+// so the chunks are large at the start and small at the end, when a slow chunk
+// would leave the other workers idle
+class ChunkCursor {
+public:
+    ChunkCursor(size_t count, size_t workers, size_t min_chunk = 1);
+    ChunkCursor(const ChunkCursor&) = delete;
+    ChunkCursor& operator=(const ChunkCursor&) = delete;
+
+    // the next chunk [first, last), false if all indices are handed out
+    bool next(size_t& first, size_t& last);
+    // the first index not handed out yet. When the workers have stopped taking chunks
+    // and the ones taken are done, the indices before it are done
+    size_t position() const;
+
+private:
+    std::atomic<size_t> next_;
+    const size_t count_;
+    const size_t divisor_;
+    const size_t min_chunk_;
+};
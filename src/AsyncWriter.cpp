@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "AsyncWriter.h"
+
+namespace {
+
+bool writeAll(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t done = ::write(fd, data, size);
+        if (done <= 0) {
+            return false;
+        }
+        data += done;
+        size -= done;
+    }
+    return true;
+}
+
+// the rename of a file is on the disk once its directory is
+bool syncDirectory(const std::string& path) {
+    size_t slash = path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : path.substr(0, slash + 1);
+    int fd = ::open(dir.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool good = fsync(fd) == 0;
+    ::close(fd);
+    return good;
+}
+
+} // namespace
+
+AsyncWriter::AsyncWriter(bool sync, size_t block_size) : sync_(sync), block_size_(std::max<size_t>(1, block_size)),
+    producer_(std::this_thread::get_id()), blocks_(0), busy_(false), failed_(false), stop_(false), fd_(-1), broken_(false) {
+    thread_ = std::thread(&AsyncWriter::run, this);
+}
+
+AsyncWriter::~AsyncWriter() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(mut_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+}
+
+void AsyncWriter::open(const std::string& path, bool append) {
+    push(Task(append ? Append : Open, path));
+}
+
+void AsyncWriter::write(const uint8_t* data, size_t size) {
+    assert(std::this_thread::get_id() == producer_);
+    while (size > 0) {
+        if (!block_) {
+            std::unique_lock<std::mutex> lock(mut_);
+            // the third block waits until one of the two is written
+            cv_.wait(lock, [this] { return !free_.empty() || blocks_ < 2; });
+            if (free_.empty()) {
+                blocks_++;
+                block_.reset(new std::vector<uint8_t>());
+                block_->reserve(block_size_);
+            } else {
+                block_ = std::move(free_.back());
+                free_.pop_back();
+            }
+            block_->clear();
+        }
+        size_t part = std::min(size, block_size_ - block_->size());
+        block_->insert(block_->end(), data, data + part);
+        data += part;
+        size -= part;
+        if (block_->size() == block_size_) {
+            Task task(Data);
+            task.data = std::move(block_);
+            push(std::move(task));
+        }
+    }
+}
+
+void AsyncWriter::patch(uint64_t offset, const uint8_t* data, size_t size) {
+    Task task(Patch);
+    task.offset = offset;
+    task.data.reset(new std::vector<uint8_t>(data, data + size));
+    push(std::move(task));
+}
+
+void AsyncWriter::finish() {
+    push(Task(Finish));
+}
+
+bool AsyncWriter::wait() {
+    std::unique_lock<std::mutex> lock(mut_);
+    cv_.wait(lock, [this] { return tasks_.empty() && !busy_; });
+    bool good = !failed_;
+    failed_ = false;
+    return good;
+}
+
+void AsyncWriter::push(Task task) {
+    assert(std::this_thread::get_id() == producer_);
+    {
+        std::lock_guard<std::mutex> lock(mut_);
+        // the data of the current block comes first
+        if (task.kind != Data && block_ && !block_->empty()) {
+            Task data(Data);
+            data.data = std::move(block_);
+            tasks_.push_back(std::move(data));
+        }
+        tasks_.push_back(std::move(task));
+    }
+    cv_.notify_all();
+}
+
+void AsyncWriter::run() {
+    std::unique_lock<std::mutex> lock(mut_);
+    for (;;) {
+        cv_.wait(lock, [this] { return !tasks_.empty() || stop_; });
+        if (tasks_.empty()) {
+            return;
+        }
+        Task task = std::move(tasks_.front());
+        tasks_.pop_front();
+        busy_ = true;
+        lock.unlock();
+        bool good = execute(task);
+        lock.lock();
+        failed_ = failed_ || !good;
+        if (task.kind == Data) {
+            free_.push_back(std::move(task.data));
+        }
+        busy_ = false;
+        cv_.notify_all();
+    }
+}
+
+bool AsyncWriter::execute(Task& task) {
+    switch (task.kind) {
+    case Open:
+    case Append:
+        path_ = task.path;
+        broken_ = false;
+        if (task.kind == Open) {
+            temp_ = path_ + ".tmp";
+            fd_ = ::open(temp_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        } else {
+            temp_.clear();
+            fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT, 0644);
+            if (fd_ >= 0 && lseek(fd_, 0, SEEK_END) < 0) {
+                ::close(fd_);
+                fd_ = -1;
+            }
+        }
+        return fd_ >= 0;
+    case Data:
+        if (fd_ >= 0 && writeAll(fd_, task.data->data(), task.data->size())) {
+            return true;
+        }
+        broken_ = true;
+        return false;
+    case Patch:
+        if (fd_ >= 0 && pwrite(fd_, task.data->data(), task.data->size(), task.offset) == ssize_t(task.data->size())) {
+            return true;
+        }
+        broken_ = true;
+        return false;
+    case Finish: {
+        if (fd_ < 0) {
+            return false;
+        }
+        bool good = !broken_ && (!sync_ || fsync(fd_) == 0);
+        good = ::close(fd_) == 0 && good;
+        fd_ = -1;
+        if (temp_.empty()) {
+            return good;
+        }
+        // a failed file does not replace the old one
+        if (good && std::rename(temp_.c_str(), path_.c_str()) == 0) {
+            return !sync_ || syncDirectory(path_);
+        }
+        std::remove(temp_.c_str());
+        return false;
+    }
+    }
+    return false;
+}
@@ -1,63 +1,80 @@
 #include <algorithm>
+#include <cstring>
 
 #include "Certificate.h"
 
-Certificate::Certificate(): size_(0), data_(nullptr) {
+Certificate::Certificate(): size_(0) {
 }
 
 Certificate::Certificate(size_t m): size_(m) {
-    data_ = new uint8_t[m];
+    if (!isInline()) {
+        data_ = new uint8_t[m];
+    }
 }
 
 Certificate::~Certificate() {
-    delete[] data_;
+    if (!isInline()) {
+        delete[] data_;
+    }
 }
 
-Certificate::Certificate(const Certificate& cert) : size_(cert.size_) {
-    data_ = new uint8_t[size_];
-    for (size_t i = 0; i < size_; ++i) {
-        data_[i] = cert.data_[i];
-    }
+Certificate::Certificate(const Certificate& cert) : Certificate(cert.size_) {
+    std::memcpy(data(), cert.data(), size_);
 }
 
-Certificate::Certificate(Certificate&& cert) : size_(cert.size_), data_(cert.data_) {
+Certificate::Certificate(Certificate&& cert) : size_(cert.size_) {
+    if (isInline()) {
+        std::memcpy(small_, cert.small_, size_);
+    } else {
+        data_ = cert.data_;
+    }
     cert.size_ = 0;
-    cert.data_ = nullptr;
 }
 
 Certificate& Certificate::operator=(const Certificate& cert) {
-    if (cert.data_ == data_) {
+    if (&cert == this) {
         return *this;
     }
     if (size_ != cert.size_) {
-        delete[] data_;
+        if (!isInline()) {
+            delete[] data_;
+        }
         size_ = cert.size_;
-        data_ = new uint8_t[size_];
-    }
-    for (size_t i = 0; i < size_; ++i) {
-        data_[i] = cert.data_[i];
+        if (!isInline()) {
+            data_ = new uint8_t[size_];
+        }
     }
+    std::memcpy(data(), cert.data(), size_);
     return *this;
 }
 
 Certificate& Certificate::operator=(Certificate&& cert) {
-    if (cert.data_ == data_) {
+    if (&cert == this) {
         return *this;
     }
-    delete[] data_;
+    if (!isInline()) {
+        delete[] data_;
+    }
     size_ = cert.size_;
-    data_ = cert.data_;
+    if (isInline()) {
+        std::memcpy(small_, cert.small_, size_);
+    } else {
+        data_ = cert.data_;
+    }
     cert.size_ = 0;
-    cert.data_ = nullptr;
     return *this;
 }
 
+bool Certificate::isInline() const {
+    return size_ <= inline_size;
+}
+
 uint8_t& Certificate::operator[](size_t i) {
-    return data_[i];
+    return data()[i];
 }
 
 const uint8_t& Certificate::operator[](size_t i) const {
-    return data_[i];
+    return data()[i];
 }
 
 size_t Certificate::size() const {
@@ -65,16 +82,60 @@ size_t Certificate::size() const {
 }
 
 uint8_t* Certificate::data() const {
-    return data_;
+    return isInline() ? const_cast<uint8_t*>(small_) : data_;
+}
+
+// the high and low halves of the 128-bit product folded together
+static inline uint64_t mix(uint64_t a, uint64_t b) {
+    __uint128_t r = (__uint128_t)a * b;
+    return uint64_t(r) ^ uint64_t(r >> 64);
+}
+
+static inline uint64_t read8(const uint8_t* data) {
+    uint64_t w;
+    std::memcpy(&w, data, 8);
+    return w;
+}
+
+static inline uint64_t read4(const uint8_t* data) {
+    uint32_t w;
+    std::memcpy(&w, data, 4);
+    return w;
+}
+
+// hashing 16 bytes per step in the manner of wyhash. Short certificates
+// are read by overlapping loads of fixed size, never byte by byte
+size_t hashBytes(const uint8_t* data, size_t size) {
+    static const uint64_t k0 = 0xA0761D6478BD642Full;
+    static const uint64_t k1 = 0xE7037ED1A0B428DBull;
+    static const uint64_t k2 = 0x8EBC6AF09C88C6E3ull;
+    uint64_t h = k0;
+    uint64_t a;
+    uint64_t b;
+    if (size <= 16) {
+        if (size >= 4) {
+            size_t s = (size >> 3) << 2;
+            a = (read4(data) << 32) | read4(data + s);
+            b = (read4(data + size - 4) << 32) | read4(data + size - 4 - s);
+        } else if (size > 0) {
+            a = (uint64_t(data[0]) << 16) | (uint64_t(data[size >> 1]) << 8) | data[size - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = 0;
+        for (; i + 16 < size; i += 16) {
+            h = mix(read8(data + i) ^ k1, read8(data + i + 8) ^ h);
+        }
+        a = read8(data + size - 16);
+        b = read8(data + size - 8);
+    }
+    return mix(k2 ^ size, mix(a ^ k1, b ^ h));
 }
 
 size_t std::hash<Certificate>::operator()(const Certificate& cert) const {
-    static const size_t p = 1000000009;
-    size_t h = 0;
-    for (size_t i = 0; i < cert.size(); ++i) {
-        h = h * p + cert[i];
-    }
-    return h;
+    return hashBytes(cert.data(), cert.size());
 }
 
 
@@ -102,24 +163,20 @@ int compareCertificates(const Certificate& C, const Certificate& D) {
     if (C.size() < D.size()) {
         return 1;
     }
-    size_t l = C.size();
-    size_t i = 0;
-
-    while (i < l && C[i] == D[i]) {
-        i++;
-    }
-
-    if (i >= l) {
+    if (C.size() == 0) {
         return 0;
     }
-
-    if (C[i] > D[i]) {
+    // larger bytes go first
+    int c = std::memcmp(C.data(), D.data(), C.size());
+    if (c > 0) {
         return -1;
-    } else {
+    }
+    if (c < 0) {
         return 1;
     }
+    return 0;
 }
 
 bool operator==(const Certificate& C, const Certificate& D) {
-    return compareCertificates(C, D) == 0;
+    return C.size() == D.size() && (C.size() == 0 || std::memcmp(C.data(), D.data(), C.size()) == 0);
 }
@@ -0,0 +1,102 @@
+#include <cstring>
+
+#include "CertificateTable.h"
+#include "Certificate.h"
+
+CertificateTable::CertificateTable(size_t length) : length_(length), size_(0), mask_(0) {
+}
+
+size_t CertificateTable::length() const {
+    return length_;
+}
+
+size_t CertificateTable::size() const {
+    return size_;
+}
+
+size_t CertificateTable::capacity() const {
+    return tags_.size();
+}
+
+size_t CertificateTable::memory() const {
+    return tags_.capacity() + arena_.capacity();
+}
+
+// the slot holding the certificate or the empty slot where it would go
+size_t CertificateTable::find(const uint8_t* cert, size_t hash, uint8_t& tag) const {
+    // the hash is mixed once more, since a sharded set gives to one table
+    // only hashes with equal top bits
+    hash ^= hash >> 30;
+    hash *= 0xBF58476D1CE4E5B9ull;
+    hash ^= hash >> 27;
+    hash *= 0x94D049BB133111EBull;
+    hash ^= hash >> 31;
+    tag = 0x80 | (hash >> 57);
+    size_t i = hash & mask_;
+    while (tags_[i]) {
+        if (tags_[i] == tag && std::memcmp(&arena_[i * length_], cert, length_) == 0) {
+            return i;
+        }
+        i = (i + 1) & mask_;
+    }
+    return i;
+}
+
+bool CertificateTable::insert(const uint8_t* cert, size_t hash) {
+    // the load factor stays below 3/4
+    if (4 * (size_ + 1) > 3 * tags_.size()) {
+        grow();
+    }
+    uint8_t tag;
+    size_t i = find(cert, hash, tag);
+    if (tags_[i]) {
+        return false;
+    }
+    tags_[i] = tag;
+    std::memcpy(&arena_[i * length_], cert, length_);
+    size_++;
+    return true;
+}
+
+bool CertificateTable::contains(const uint8_t* cert, size_t hash) const {
+    if (size_ == 0) {
+        return false;
+    }
+    uint8_t tag;
+    return tags_[find(cert, hash, tag)] != 0;
+}
+
+void CertificateTable::clear() {
+    size_ = 0;
+    mask_ = 0;
+    tags_ = std::vector<uint8_t>();
+    arena_ = std::vector<uint8_t>();
+}
+
+bool CertificateTable::occupied(size_t slot) const {
+    return tags_[slot] != 0;
+}
+
+const uint8_t* CertificateTable::at(size_t slot) const {
+    return &arena_[slot * length_];
+}
+
+void CertificateTable::grow() {
+    std::vector<uint8_t> tags;
+    std::vector<uint8_t> arena;
+    tags.swap(tags_);
+    arena.swap(arena_);
+    size_t capacity = tags.empty() ? 16 : 2 * tags.size();
+    tags_.assign(capacity, 0);
+    arena_.assign(capacity * length_, 0);
+    mask_ = capacity - 1;
+    for (size_t j = 0; j < tags.size(); j++) {
+        if (tags[j]) {
+            const uint8_t* cert = &arena[j * length_];
+            uint8_t tag;
+            size_t i = find(cert, hashBytes(cert, length_), tag);
+            tags_[i] = tag;
+            std::memcpy(&arena_[i * length_], cert, length_);
+        }
+    }
+}
@@ -0,0 +1,98 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "Checkpoint.h"
+
+Checkpoint::Checkpoint(const std::string& path) : path_(path) {
+    std::ifstream stream(path);
+    std::string line;
+    while (std::getline(stream, line)) {
+        std::istringstream words(line);
+        std::string tag;
+        if (!(words >> tag)) {
+            continue;
+        }
+        std::vector<size_t> values;
+        size_t value;
+        while (words >> value) {
+            values.push_back(value);
+        }
+        lines_.emplace_back(tag, std::move(values));
+    }
+}
+
+const std::string& Checkpoint::path() const {
+    return path_;
+}
+
+bool Checkpoint::empty() const {
+    return lines_.empty();
+}
+
+std::vector<std::vector<size_t>> Checkpoint::get(const std::string& tag) const {
+    std::vector<std::vector<size_t>> values;
+    for (const auto& line : lines_) {
+        if (line.first == tag) {
+            values.push_back(line.second);
+        }
+    }
+    return values;
+}
+
+void Checkpoint::add(const std::string& tag, const std::vector<size_t>& values) {
+    lines_.emplace_back(tag, values);
+}
+
+void Checkpoint::clear() {
+    lines_.clear();
+}
+
+void Checkpoint::write(AsyncWriter& out) const {
+    std::ostringstream text;
+    for (const auto& line : lines_) {
+        text << line.first;
+        for (size_t value : line.second) {
+            text << " " << value;
+        }
+        text << "\n";
+    }
+    const std::string data = text.str();
+    out.open(path_);
+    out.write((const uint8_t*)data.data(), data.size());
+    out.finish();
+}
+
+void Checkpoint::remove() {
+    lines_.clear();
+    std::remove(path_.c_str());
+}
+
+CheckpointClock::CheckpointClock(double seconds) :
+    interval_(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds))),
+    deadline_(0), due_(false) {
+    restart();
+}
+
+bool CheckpointClock::enabled() const {
+    return interval_.count() > 0;
+}
+
+bool CheckpointClock::due() {
+    if (!enabled()) {
+        return false;
+    }
+    if (!due_ && std::chrono::steady_clock::now().time_since_epoch().count() >= deadline_) {
+        due_ = true;
+    }
+    return due_;
+}
+
+bool CheckpointClock::paused() const {
+    return due_;
+}
+
+void CheckpointClock::restart() {
+    deadline_ = (std::chrono::steady_clock::now() + interval_).time_since_epoch().count();
+    due_ = false;
+}
@@ -0,0 +1,687 @@
+#include <algorithm>
+#include <cstring>
+#include <queue>
+
+#include "CompressedFile.h"
+#include "Graph.h"
+
+namespace {
+
+// every code is decoded by one lookup in a table of 2^max_code entries
+const size_t max_code = 11;
+// the bytes of a block are cut into this many parts with own streams, which are decoded side by side
+const size_t streams = 4;
+// two tables of 256 code lengths, a nibble each, and the sizes of the prefix stream
+// and of the byte streams but the last one (4 bytes each)
+const size_t tables_size = 256 + 4 * streams;
+// block size, number of blocks and the position of the index after the header
+const size_t fixed_size = GrHeader::size + 16;
+// the room after the certificates and the bytes of a decoded block for the wide copies
+const size_t slack = 32;
+
+// lengths of a Huffman code of at most max_code bits for the symbol counts.
+// If the code is too long, the counts are halved until it fits
+void codeLengths(std::vector<uint64_t> counts, uint8_t* lengths) {
+    for (;;) {
+        std::fill(lengths, lengths + 256, 0);
+        typedef std::pair<uint64_t, size_t> Node;
+        std::priority_queue<Node, std::vector<Node>, std::greater<Node>> heap;
+        for (size_t s = 0; s < 256; s++) {
+            if (counts[s]) {
+                heap.push({counts[s], s});
+            }
+        }
+        if (heap.empty()) {
+            return;
+        }
+        if (heap.size() == 1) {
+            lengths[heap.top().second] = 1;
+            return;
+        }
+        // leaves are 0..255, inner nodes come after them
+        std::vector<size_t> parent(512, 0);
+        size_t next = 256;
+        while (heap.size() > 1) {
+            Node a = heap.top();
+            heap.pop();
+            Node b = heap.top();
+            heap.pop();
+            parent[a.second] = next;
+            parent[b.second] = next;
+            heap.push({a.first + b.first, next++});
+        }
+        size_t root = next - 1;
+        size_t longest = 0;
+        for (size_t s = 0; s < 256; s++) {
+            if (!counts[s]) {
+                continue;
+            }
+            size_t depth = 0;
+            for (size_t v = s; v != root; v = parent[v]) {
+                depth++;
+            }
+            lengths[s] = depth;
+            longest = std::max(longest, depth);
+        }
+        if (longest <= max_code) {
+            return;
+        }
+        for (uint64_t& c : counts) {
+            if (c) {
+                c = (c + 1) / 2;
+            }
+        }
+    }
+}
+
+// canonical codes: shorter codes first, then by the symbol
+void canonicalCodes(const uint8_t* lengths, uint16_t* codes) {
+    uint16_t number[max_code + 1] = {0};
+    for (size_t s = 0; s < 256; s++) {
+        number[lengths[s]]++;
+    }
+    number[0] = 0;
+    uint16_t next[max_code + 1] = {0};
+    uint16_t code = 0;
+    for (size_t len = 1; len <= max_code; len++) {
+        code = (code + number[len - 1]) << 1;
+        next[len] = code;
+    }
+    for (size_t s = 0; s < 256; s++) {
+        if (lengths[s]) {
+            codes[s] = next[lengths[s]]++;
+        }
+    }
+}
+
+struct BitWriter {
+    std::vector<uint8_t>& out;
+    uint64_t acc = 0;
+    size_t bits = 0;
+
+    explicit BitWriter(std::vector<uint8_t>& out) : out(out) {
+    }
+
+    void put(uint16_t code, size_t len) {
+        acc = (acc << len) | code;
+        bits += len;
+        while (bits >= 8) {
+            bits -= 8;
+            out.push_back(uint8_t(acc >> bits));
+        }
+    }
+
+    void finish() {
+        if (bits) {
+            out.push_back(uint8_t(acc << (8 - bits)));
+        }
+        bits = 0;
+    }
+};
+
+struct BitReader {
+    const uint8_t* p = nullptr;
+    const uint8_t* end = nullptr;
+    // the next bits of the stream from the top bit on
+    uint64_t window = 0;
+    size_t bits = 0;
+
+    BitReader() = default;
+
+    BitReader(const uint8_t* p, const uint8_t* end) : p(p), end(end) {
+    }
+
+    void refill() {
+        if (end - p >= 8) {
+            uint64_t next = 0;
+            for (size_t i = 0; i < 8; i++) {
+                next = (next << 8) | p[i];
+            }
+            window |= next >> bits;
+            p += (63 - bits) >> 3;
+            bits |= 56;
+            return;
+        }
+        while (bits <= 56) {
+            uint64_t byte = p < end ? *p++ : 0;
+            window |= byte << (56 - bits);
+            bits += 8;
+        }
+    }
+
+    void consume(size_t len) {
+        window <<= len;
+        bits -= len;
+    }
+};
+
+struct Decoder {
+    // for the next max_code bits of the stream: the first symbol, the second one if its code
+    // fits too, the length of the first code, the length of both codes and the number of symbols
+    uint32_t table[1 << max_code];
+
+    void build(const uint8_t* lengths) {
+        // the bits of a damaged block give a zero symbol which takes no bits
+        std::fill(table, table + (1 << max_code), uint32_t(1) << 24);
+        uint16_t codes[256];
+        canonicalCodes(lengths, codes);
+        // the symbols by the length of their codes, the lengths of a damaged block
+        // may not give a prefix code
+        size_t position[max_code + 2] = {0};
+        for (size_t s = 0; s < 256; s++) {
+            if (lengths[s] && codes[s] < (1 << lengths[s])) {
+                position[lengths[s] + 1]++;
+            }
+        }
+        for (size_t len = 1; len <= max_code; len++) {
+            position[len + 1] += position[len];
+        }
+        uint8_t symbols[256];
+        size_t used = position[max_code + 1];
+        for (size_t s = 0; s < 256; s++) {
+            if (lengths[s] && codes[s] < (1 << lengths[s])) {
+                symbols[position[lengths[s]]++] = s;
+            }
+        }
+        for (size_t a = 0; a < used; a++) {
+            size_t first = symbols[a];
+            size_t len = lengths[first];
+            size_t start = size_t(codes[first]) << (max_code - len);
+            uint32_t single = first | (len << 16) | (len << 20) | (uint32_t(1) << 24);
+            std::fill(table + start, table + start + (size_t(1) << (max_code - len)), single);
+            for (size_t b = 0; b < used && len + lengths[symbols[b]] <= max_code; b++) {
+                size_t second = symbols[b];
+                size_t rest = max_code - len - lengths[second];
+                size_t from = start + (size_t(codes[second]) << rest);
+                uint32_t pair = first | (second << 8) | (len << 16) | ((len + lengths[second]) << 20) | (uint32_t(2) << 24);
+                std::fill(table + from, table + from + (size_t(1) << rest), pair);
+            }
+        }
+    }
+
+    // one symbol, the reader must have max_code bits
+    uint8_t decode(BitReader& r) const {
+        uint32_t entry = table[r.window >> (64 - max_code)];
+        r.consume((entry >> 16) & 15);
+        return entry & 0xff;
+    }
+
+    // one or two symbols, two bytes are written
+    void decodePair(BitReader& r, uint8_t*& out) const {
+        uint32_t entry = table[r.window >> (64 - max_code)];
+        r.consume((entry >> 20) & 15);
+        out[0] = entry & 0xff;
+        out[1] = (entry >> 8) & 0xff;
+        out += entry >> 24;
+    }
+};
+
+// copies size bytes in pieces of 16, at least one, so up to 16 bytes after them are read
+// and overwritten. For certificates of at most 16 bytes there is no branch to mispredict
+void copyWide(uint8_t* to, const uint8_t* from, size_t size) {
+    size_t i = 0;
+    do {
+        std::memcpy(to + i, from + i, 16);
+        i += 16;
+    } while (i < size);
+}
+
+size_t commonPrefix(const uint8_t* a, const uint8_t* b, size_t length) {
+    size_t p = 0;
+    while (p < length && a[p] == b[p]) {
+        p++;
+    }
+    return p;
+}
+
+// appends the coded block of count certificates to out
+void encodeBlock(const uint8_t* certs, size_t count, size_t length, std::vector<uint8_t>& out) {
+    std::vector<uint8_t> prefixes;
+    std::vector<uint8_t> bytes;
+    for (size_t i = 1; i < count; i++) {
+        const uint8_t* prev = certs + (i - 1) * length;
+        const uint8_t* cur = certs + i * length;
+        size_t p = commonPrefix(prev, cur, length);
+        prefixes.push_back(p);
+        if (p < length) {
+            bytes.push_back(prev[p] - cur[p]);
+            bytes.insert(bytes.end(), cur + p + 1, cur + length);
+        }
+    }
+    std::vector<uint64_t> prefix_counts(256, 0);
+    std::vector<uint64_t> byte_counts(256, 0);
+    for (uint8_t p : prefixes) {
+        prefix_counts[p]++;
+    }
+    for (uint8_t b : bytes) {
+        byte_counts[b]++;
+    }
+    uint8_t prefix_lengths[256];
+    uint8_t byte_lengths[256];
+    codeLengths(prefix_counts, prefix_lengths);
+    codeLengths(byte_counts, byte_lengths);
+    uint16_t prefix_codes[256];
+    uint16_t byte_codes[256];
+    canonicalCodes(prefix_lengths, prefix_codes);
+    canonicalCodes(byte_lengths, byte_codes);
+    for (const uint8_t* lengths : {prefix_lengths, byte_lengths}) {
+        for (size_t s = 0; s < 256; s += 2) {
+            out.push_back(lengths[s] | (lengths[s + 1] << 4));
+        }
+    }
+
+    // the prefix stream and the byte streams, each with its part of the bytes
+    std::vector<uint8_t> coded[1 + streams];
+    BitWriter prefix_writer(coded[0]);
+    for (uint8_t p : prefixes) {
+        prefix_writer.put(prefix_codes[p], prefix_lengths[p]);
+    }
+    prefix_writer.finish();
+    size_t part = (bytes.size() + streams - 1) / streams;
+    for (size_t s = 0; s < streams; s++) {
+        BitWriter writer(coded[1 + s]);
+        for (size_t k = s * part; k < std::min(bytes.size(), (s + 1) * part); k++) {
+            writer.put(byte_codes[bytes[k]], byte_lengths[bytes[k]]);
+        }
+        writer.finish();
+    }
+    for (size_t s = 0; s < streams; s++) {
+        uint8_t size[4];
+        putLE(size, coded[s].size(), 4);
+        out.insert(out.end(), size, size + 4);
+    }
+    for (const std::vector<uint8_t>& stream : coded) {
+        out.insert(out.end(), stream.begin(), stream.end());
+    }
+}
+
+// decodes the streams of the readers into [out[s], end[s]) side by side, the lookups of
+// different streams do not wait for each other
+template <size_t n>
+void decodeStreams(const Decoder& decoder, const BitReader* from, uint8_t* const* to, uint8_t* const* end) {
+    // local copies, so the compiler keeps them in registers although the bytes written may alias them
+    BitReader readers[n];
+    uint8_t* out[n];
+    for (size_t s = 0; s < n; s++) {
+        readers[s] = from[s];
+        out[s] = to[s];
+    }
+    // a refill gives at least 56 bits, enough for 5 codes, which are up to 10 symbols
+    const ptrdiff_t room = 10;
+    for (;;) {
+        bool full = false;
+        for (size_t s = 0; s < n; s++) {
+            full |= end[s] - out[s] < room;
+        }
+        if (full) {
+            break;
+        }
+        for (size_t s = 0; s < n; s++) {
+            readers[s].refill();
+        }
+        for (size_t j = 0; j < 5; j++) {
+            for (size_t s = 0; s < n; s++) {
+                decoder.decodePair(readers[s], out[s]);
+            }
+        }
+    }
+    for (size_t s = 0; s < n; s++) {
+        BitReader& r = readers[s];
+        while (end[s] - out[s] >= room) {
+            r.refill();
+            for (size_t j = 0; j < 5; j++) {
+                decoder.decodePair(r, out[s]);
+            }
+        }
+        while (out[s] < end[s]) {
+            if (r.bits < max_code) {
+                r.refill();
+            }
+            *out[s]++ = decoder.decode(r);
+        }
+    }
+}
+
+// out has room for slack bytes after the count certificates
+void decodeBlock(const uint8_t* data, const uint8_t* end, const uint8_t* first, size_t count, size_t length, uint8_t* out) {
+    if (count == 0) {
+        return;
+    }
+    std::copy(first, first + length, out);
+    if (end - data < ptrdiff_t(tables_size)) {
+        std::fill(out + length, out + count * length, 0);
+        return;
+    }
+    uint8_t lengths[2][256];
+    for (size_t t = 0; t < 2; t++) {
+        for (size_t s = 0; s < 256; s += 2) {
+            lengths[t][s] = data[t * 128 + s / 2] & 15;
+            lengths[t][s + 1] = data[t * 128 + s / 2] >> 4;
+        }
+        // a damaged block may have longer codes, they are left out
+        for (size_t s = 0; s < 256; s++) {
+            if (lengths[t][s] > max_code) {
+                lengths[t][s] = 0;
+            }
+        }
+    }
+    Decoder prefixes;
+    Decoder bytes;
+    prefixes.build(lengths[0]);
+    bytes.build(lengths[1]);
+
+    // the streams end where the next one begins, the last one at the end of the block
+    const uint8_t* begin[streams + 2];
+    begin[0] = data + tables_size;
+    for (size_t s = 0; s < streams; s++) {
+        begin[s + 1] = begin[s] + std::min<uint64_t>(getLE(data + 256 + 4 * s, 4), end - begin[s]);
+    }
+    begin[streams + 1] = end;
+
+    // the prefix lengths first, they give the number of bytes
+    thread_local std::vector<uint8_t> lengths_of_prefixes;
+    thread_local std::vector<uint8_t> symbols;
+    lengths_of_prefixes.resize(count + slack);
+    BitReader prefix_reader(begin[0], begin[1]);
+    uint8_t* prefix_out = lengths_of_prefixes.data() + 1;
+    uint8_t* prefix_end = lengths_of_prefixes.data() + count;
+    decodeStreams<1>(prefixes, &prefix_reader, &prefix_out, &prefix_end);
+    size_t total = 0;
+    for (size_t i = 1; i < count; i++) {
+        lengths_of_prefixes[i] = std::min<size_t>(lengths_of_prefixes[i], length);
+        total += length - lengths_of_prefixes[i];
+    }
+
+    symbols.resize(total + slack);
+    size_t part = (total + streams - 1) / streams;
+    BitReader readers[streams] = {{begin[1], begin[2]}, {begin[2], begin[3]}, {begin[3], begin[4]}, {begin[4], begin[5]}};
+    uint8_t* parts[streams];
+    uint8_t* ends[streams];
+    for (size_t s = 0; s < streams; s++) {
+        parts[s] = symbols.data() + std::min(total, s * part);
+        ends[s] = symbols.data() + std::min(total, (s + 1) * part);
+    }
+    decodeStreams<streams>(bytes, readers, parts, ends);
+
+    const uint8_t* symbol = symbols.data();
+    for (size_t i = 1; i < count; i++) {
+        const uint8_t* prev = out + (i - 1) * length;
+        uint8_t* cur = out + i * length;
+        size_t p = lengths_of_prefixes[i];
+        // a certificate equal to the previous one takes no byte, the ones written after it
+        // are overwritten by the next certificate
+        size_t rest = length - p;
+        copyWide(cur, prev, p);
+        cur[p] = prev[p] - *symbol;
+        symbol += rest != 0;
+        copyWide(cur + p + 1, symbol, rest - (rest != 0));
+        symbol += rest - (rest != 0);
+    }
+}
+
+} // namespace
+
+CompressedWriter::CompressedWriter(const std::string& path, const GrHeader& header, size_t block_size) :
+    open_(false), good_(false), header_(header), block_size_(std::max<size_t>(1, block_size)), position_(fixed_size) {
+    header_.compressed = true;
+    header_.count = 0;
+    header_.checksum = 0;
+    // the writer finds out itself whether the certificates come sorted
+    header_.sorted = true;
+    if (header_.length == 0 || header_.length > 255) {
+        return;
+    }
+    open_ = true;
+    good_ = true;
+    out_.open(path);
+    // a place for the header, written by close
+    uint8_t data[fixed_size] = {0};
+    out_.write(data, fixed_size);
+}
+
+CompressedWriter::~CompressedWriter() {
+    close();
+}
+
+bool CompressedWriter::good() const {
+    return good_;
+}
+
+void CompressedWriter::add(const uint8_t* cert) {
+    if (!open_) {
+        return;
+    }
+    size_t length = header_.length;
+    const uint8_t* last = block_.empty() ? (firsts_.empty() ? nullptr : last_.data()) : block_.data() + block_.size() - length;
+    if (last && std::memcmp(last, cert, length) <= 0) {
+        header_.sorted = false;
+    }
+    block_.insert(block_.end(), cert, cert + length);
+    header_.count++;
+    header_.checksum += certificateChecksum(cert, length);
+    if (block_.size() == block_size_ * length) {
+        flush();
+    }
+}
+
+size_t CompressedWriter::count() const {
+    return header_.count;
+}
+
+void CompressedWriter::flush() {
+    if (block_.empty()) {
+        return;
+    }
+    size_t length = header_.length;
+    offsets_.push_back(position_);
+    firsts_.insert(firsts_.end(), block_.begin(), block_.begin() + length);
+    last_.assign(block_.end() - length, block_.end());
+    std::vector<uint8_t> out;
+    encodeBlock(block_.data(), block_.size() / length, length, out);
+    out_.write(out.data(), out.size());
+    position_ += out.size();
+    block_.clear();
+}
+
+void CompressedWriter::close() {
+    if (!open_) {
+        return;
+    }
+    open_ = false;
+    flush();
+    uint64_t index = position_;
+    offsets_.push_back(index);
+    std::vector<uint8_t> data(offsets_.size() * 8);
+    for (size_t b = 0; b < offsets_.size(); b++) {
+        putLE(data.data() + 8 * b, offsets_[b], 8);
+    }
+    out_.write(data.data(), data.size());
+    out_.write(firsts_.data(), firsts_.size());
+
+    uint8_t head[fixed_size];
+    header_.encode(head);
+    putLE(head + GrHeader::size, block_size_, 4);
+    putLE(head + GrHeader::size + 4, offsets_.size() - 1, 4);
+    putLE(head + GrHeader::size + 8, index, 8);
+    out_.patch(0, head, fixed_size);
+    out_.finish();
+    good_ = out_.wait();
+}
+
+CompressedFile::CompressedFile(const std::string& path) : file_(path), good_(false), block_size_(0), blocks_(0),
+    offsets_(nullptr), firsts_(nullptr) {
+    if (!file_.good() || file_.size() < fixed_size) {
+        return;
+    }
+    const uint8_t* data = file_.data();
+    if (!header_.decode(data, file_.size()) || !header_.compressed) {
+        return;
+    }
+    size_t length = header_.length;
+    block_size_ = getLE(data + GrHeader::size, 4);
+    blocks_ = getLE(data + GrHeader::size + 4, 4);
+    uint64_t index = getLE(data + GrHeader::size + 8, 8);
+    if (block_size_ == 0 || blocks_ != (header_.count + block_size_ - 1) / block_size_ ||
+        index + (blocks_ + 1) * 8 + blocks_ * length != file_.size()) {
+        return;
+    }
+    offsets_ = data + index;
+    firsts_ = offsets_ + (blocks_ + 1) * 8;
+    uint64_t last = fixed_size;
+    for (size_t b = 0; b <= blocks_; b++) {
+        uint64_t offset = getLE(offsets_ + 8 * b, 8);
+        if (offset < last || (b == 0 && offset != fixed_size)) {
+            return;
+        }
+        last = offset;
+    }
+    good_ = last == index;
+}
+
+bool CompressedFile::good() const {
+    return good_;
+}
+
+const GrHeader& CompressedFile::header() const {
+    return header_;
+}
+
+size_t CompressedFile::count() const {
+    return good_ ? header_.count : 0;
+}
+
+size_t CompressedFile::length() const {
+    return header_.length;
+}
+
+size_t CompressedFile::blocks() const {
+    return blocks_;
+}
+
+size_t CompressedFile::blockSize() const {
+    return block_size_;
+}
+
+void CompressedFile::decodeBlock(size_t b, std::vector<uint8_t>& out) const {
+    size_t length = header_.length;
+    size_t count = std::min<size_t>(block_size_, header_.count - b * block_size_);
+    // room for the wide copies of the last certificate
+    out.resize(count * length + slack);
+    const uint8_t* begin = file_.data() + getLE(offsets_ + 8 * b, 8);
+    const uint8_t* end = file_.data() + getLE(offsets_ + 8 * (b + 1), 8);
+    ::decodeBlock(begin, end, firsts_ + b * length, count, length, out.data());
+    out.resize(count * length);
+}
+
+void CompressedFile::scan(const std::function<void(size_t, const uint8_t*)>& visit) const {
+    if (!good_) {
+        return;
+    }
+    size_t length = header_.length;
+    std::vector<uint8_t> block;
+    for (size_t b = 0; b < blocks_; b++) {
+        if (b + 1 < blocks_) {
+            uint64_t begin = getLE(offsets_ + 8 * (b + 1), 8);
+            file_.prefetch(begin, getLE(offsets_ + 8 * (b + 2), 8) - begin);
+        }
+        decodeBlock(b, block);
+        for (size_t i = 0; i * length < block.size(); i++) {
+            visit(b * block_size_ + i, block.data() + i * length);
+        }
+    }
+}
+
+bool CompressedFile::contains(const uint8_t* cert) const {
+    if (!good_ || !header_.sorted) {
+        return false;
+    }
+    size_t length = header_.length;
+    // the last block whose first certificate is not after cert
+    size_t lo = 0;
+    size_t hi = blocks_;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (std::memcmp(cert, firsts_ + mid * length, length) > 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    if (lo == 0) {
+        return false;
+    }
+    thread_local std::vector<uint8_t> block;
+    decodeBlock(lo - 1, block);
+    size_t first = 0;
+    size_t last = block.size() / length;
+    while (first < last) {
+        size_t mid = (first + last) / 2;
+        int c = std::memcmp(block.data() + mid * length, cert, length);
+        if (c == 0) {
+            return true;
+        }
+        if (c > 0) {
+            first = mid + 1;
+        } else {
+            last = mid;
+        }
+    }
+    return false;
+}
+
+bool CompressedFile::verify() const {
+    if (!good_) {
+        return false;
+    }
+    uint64_t checksum = 0;
+    scan([&](size_t, const uint8_t* cert) {
+        checksum += certificateChecksum(cert, header_.length);
+    });
+    return checksum == header_.checksum;
+}
+
+namespace {
+
+void report(bool* good, bool value) {
+    if (good) {
+        *good = value;
+    }
+}
+
+} // namespace
+
+size_t compressGr(const std::string& input, const std::string& output, size_t n, bool* good) {
+    GraphFile file(input, n);
+    if (!file.good()) {
+        report(good, false);
+        return 0;
+    }
+    GrHeader header;
+    header.type = GrHeader::graph;
+    header.n = n;
+    header.length = Graph::certSize(n);
+    CompressedWriter writer(output, header);
+    for (size_t i = 0; i < file.count(); i++) {
+        writer.add(file.certificate(i));
+    }
+    writer.close();
+    report(good, writer.good());
+    return writer.count();
+}
+
+size_t decompressGr(const std::string& input, const std::string& output, bool* good) {
+    CompressedFile file(input);
+    if (!file.good()) {
+        report(good, false);
+        return 0;
+    }
+    GrHeader header = file.header();
+    header.compressed = false;
+    GrWriter writer(output, header);
+    file.scan([&](size_t, const uint8_t* cert) {
+        writer.add(cert);
+    });
+    writer.close();
+    report(good, writer.good());
+    return writer.count();
+}
@@ -0,0 +1,154 @@
+#include <algorithm>
+
+#include "ConeGenerator.h"
+
+ConeGenerator::ConeGenerator() : min_deg(1), d(0), n(0), blocked(false), visit(nullptr) {
+}
+
+ConeGenerator::ConeGenerator(const Graph& H, const SubgraphMatcher& M) : ConeGenerator() {
+    reset(H, M);
+}
+
+void ConeGenerator::reset(const Graph& H, const SubgraphMatcher& M) {
+    if (n != H.size()) {
+        pairs.clear();
+        touched.clear();
+    }
+    n = H.size();
+    blocked = false;
+    excluded.resize(n);
+    conflicts.resize(n);
+    larger.resize(n);
+    for (size_t x = 0; x < n; x++) {
+        conflicts[x].resize(n);
+        larger[x].clear();
+    }
+    for (size_t p : touched) {
+        pairs[p].clear();
+    }
+    touched.clear();
+    chosen.resize(n);
+    sets.clear();
+    starts.assign(1, 0);
+    if (size_t cycle = shortCycle(M)) {
+        // a cycle of m vertices through the new vertex joins it to the ends of a path of m - 2 edges
+        std::vector<word> paths = H.pathMatrix(cycle - 2);
+        for (size_t x = 0; x < n; x++) {
+            conflicts[x].assign(paths.data() + x * H.words());
+        }
+        return;
+    }
+    // forbidden sets of 1 or 2 vertices go to bitsets, sets of 3 vertices to the bitsets of their pairs
+    // and larger ones to lists per vertex. A set visited twice is harmless
+    M.visitForbiddenSets(H, [&](const std::vector<size_t>& S) {
+        if (S.empty()) {
+            blocked = true;
+        } else if (S.size() == 1) {
+            excluded.set(S[0]);
+        } else if (S.size() == 2) {
+            conflicts[S[0]].set(S[1]);
+            conflicts[S[1]].set(S[0]);
+        } else if (S.size() == 3) {
+            if (pairs.empty()) {
+                pairs.assign(n * n, Bitset(n));
+            }
+            for (size_t i = 0; i < 3; i++) {
+                size_t x = S[i], y = S[(i + 1) % 3], z = S[(i + 2) % 3];
+                for (size_t p : {x * n + y, y * n + x}) {
+                    if (!pairs[p].any()) {
+                        touched.push_back(p);
+                    }
+                    pairs[p].set(z);
+                }
+            }
+        } else {
+            for (size_t x : S) {
+                larger[x].push_back(starts.size() - 1);
+            }
+            sets.insert(sets.end(), S.begin(), S.end());
+            starts.push_back(sets.size());
+        }
+    });
+}
+
+size_t ConeGenerator::shortCycle(const SubgraphMatcher& M) {
+    const Graph& P = M.pattern();
+    size_t m = P.size();
+    if (m < 3 || m > 5 || P.edges() != m) {
+        return 0;
+    }
+    // a 2-regular graph on at most 5 vertices is a cycle
+    for (size_t i = 0; i < m; i++) {
+        if (P.degree(i) != 2) {
+            return 0;
+        }
+    }
+    return m;
+}
+
+bool ConeGenerator::isolated() const {
+    return !blocked;
+}
+
+void ConeGenerator::visitCones(size_t min_deg, size_t max_deg, const std::function<void(const std::vector<size_t>&)>& visit) {
+    this->min_deg = std::max<size_t>(min_deg, 1);
+    d = max_deg;
+    if (d < this->min_deg || blocked) {
+        return;
+    }
+
+    candidates.resize(d + 1);
+    for (Bitset& C : candidates) {
+        C.resize(n);
+    }
+    candidates[0].fill();
+    candidates[0] -= excluded;
+    chosen.clear();
+    cone.clear();
+    this->visit = &visit;
+    next(0);
+}
+
+void ConeGenerator::next(size_t l) {
+    if (l >= min_deg) {
+        (*visit)(cone);
+    }
+    if (l == d) {
+        return;
+    }
+
+    const Bitset& C = candidates[l];
+    // the candidates from x on, a cone below x has at most l + left vertices
+    size_t left = C.count();
+    for (size_t x = C.first(); x < n && l + left >= min_deg; x = C.next(x + 1), left--) {
+        Bitset& R = candidates[l + 1];
+        R = C;
+        R.removeBelow(x + 1);
+        R -= conflicts[x];
+        if (!pairs.empty()) {
+            for (size_t y : cone) {
+                R -= pairs[x * n + y];
+            }
+        }
+        chosen.set(x);
+        // a forbidden set with all but one vertex chosen excludes the last one
+        for (size_t i : larger[x]) {
+            size_t last = n;
+            size_t missing = 0;
+            for (size_t s = starts[i]; s < starts[i + 1]; s++) {
+                if (!chosen.test(sets[s])) {
+                    last = sets[s];
+                    missing++;
+                }
+            }
+            if (missing == 1) {
+                R.reset(last);
+            }
+        }
+
+        cone.push_back(x);
+        next(l + 1);
+        cone.pop_back();
+        chosen.reset(x);
+    }
+}
@@ -0,0 +1,328 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <queue>
+
+#include <unistd.h>
+
+#include "ExternalGraphSet.h"
+
+namespace {
+
+// the order of compareCertificates on certificates of one length
+struct Before {
+    size_t length;
+    bool operator()(const uint8_t* a, const uint8_t* b) const {
+        return std::memcmp(a, b, length) > 0;
+    }
+};
+
+} // namespace
+
+ExternalGraphSet::ExternalGraphSet(size_t n, size_t budget, const std::string& prefix, bool sync) :
+    n(n), length_(Graph::certSize(n)), limit_(0), prefix_(prefix), sync_(sync), good_(true), buffer_(n, true), buffered_(0), next_run_(0) {
+    // a slot of the flat tables takes length + 1 bytes and the tables are at least 3/8 full
+    if (budget) {
+        limit_ = std::max<size_t>(1, budget * 3 / (8 * (length_ + 1)));
+    }
+}
+
+ExternalGraphSet::~ExternalGraphSet() {
+    clear();
+}
+
+void ExternalGraphSet::insert(const Graph& G) {
+    insertIfAbsent(G);
+}
+
+bool ExternalGraphSet::insertIfAbsent(const Graph& G) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mut_);
+        if (inRuns(G.certificate().data()) || !buffer_.insertIfAbsent(G)) {
+            return false;
+        }
+        // after a failed spill the buffer takes the rest
+        if (!limit_ || ++buffered_ < limit_ || !good_) {
+            return true;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(mut_);
+    // another thread may have spilled the buffer meanwhile
+    if (buffered_ >= limit_ && good_) {
+        good_ = spill();
+    }
+    return true;
+}
+
+bool ExternalGraphSet::contains(const Graph& G) const {
+    std::shared_lock<std::shared_mutex> lock(mut_);
+    return buffer_.contains(G) || inRuns(G.certificate().data());
+}
+
+size_t ExternalGraphSet::size() const {
+    std::shared_lock<std::shared_mutex> lock(mut_);
+    size_t s = buffer_.size();
+    for (const Run& run : runs_) {
+        s += run.count;
+    }
+    return s;
+}
+
+bool ExternalGraphSet::empty() const {
+    return size() == 0;
+}
+
+size_t ExternalGraphSet::runs() const {
+    std::shared_lock<std::shared_mutex> lock(mut_);
+    return runs_.size();
+}
+
+bool ExternalGraphSet::good() const {
+    std::shared_lock<std::shared_mutex> lock(mut_);
+    return good_;
+}
+
+bool ExternalGraphSet::inRuns(const uint8_t* cert) const {
+    for (const Run& run : runs_) {
+        if (inRun(run, cert)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ExternalGraphSet::inRun(const Run& run, const uint8_t* cert) const {
+    Before before{length_};
+    // the last block starting not after cert
+    size_t lo = 0;
+    size_t hi = run.index.size() / length_;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (before(cert, run.index.data() + mid * length_)) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    if (lo == 0) {
+        return false;
+    }
+    size_t first = (lo - 1) * index_step;
+    size_t last = std::min(run.count, first + index_step);
+    const uint8_t* data = run.file.data();
+    while (first < last) {
+        size_t mid = (first + last) / 2;
+        const uint8_t* c = data + mid * length_;
+        int cmp = std::memcmp(c, cert, length_);
+        if (cmp == 0) {
+            return true;
+        }
+        if (cmp > 0) {
+            first = mid + 1;
+        } else {
+            last = mid;
+        }
+    }
+    return false;
+}
+
+bool ExternalGraphSet::spill() {
+    // pointers into the buffer, so that the peak memory stays close to the buffer itself
+    std::vector<const uint8_t*> list = buffer_.getSorted();
+
+    Run run;
+    run.path = prefix_ + ".run" + std::to_string(next_run_);
+    bool good = writeRun(run, [&list](const std::function<void(const uint8_t*)>& add) {
+        for (const uint8_t* cert : list) {
+            add(cert);
+        }
+    });
+    if (!good) {
+        return false;
+    }
+    next_run_++;
+    runs_.push_back(std::move(run));
+
+    buffer_.clear();
+    buffered_ = 0;
+    return true;
+}
+
+bool ExternalGraphSet::mergeRuns() {
+    Run run;
+    run.path = prefix_ + ".run" + std::to_string(next_run_);
+    if (!writeRun(run, [this](const std::function<void(const uint8_t*)>& add) {
+            merge({}, add);
+        })) {
+        return false;
+    }
+    next_run_++;
+    // the last checkpoint may still name the old runs
+    for (Run& old : runs_) {
+        old.file.close();
+        retired_.push_back(old.path);
+    }
+    runs_.clear();
+    runs_.push_back(std::move(run));
+    return true;
+}
+
+bool ExternalGraphSet::writeRun(Run& run, const std::function<void(const std::function<void(const uint8_t*)>&)>& produce) const {
+    FILE* file = std::fopen(run.path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool good = true;
+    run.count = 0;
+    run.index.clear();
+    produce([&](const uint8_t* cert) {
+        good = good && std::fwrite(cert, 1, length_, file) == length_;
+        if (run.count % index_step == 0) {
+            run.index.insert(run.index.end(), cert, cert + length_);
+        }
+        run.count++;
+    });
+    good = good && std::fflush(file) == 0 && (!sync_ || fsync(fileno(file)) == 0);
+    good = std::fclose(file) == 0 && good;
+    if (good) {
+        run.file.open(run.path);
+        good = run.file.good() && run.file.size() == run.count * length_;
+    }
+    if (!good) {
+        run.file.close();
+        std::remove(run.path.c_str());
+    }
+    return good;
+}
+
+void ExternalGraphSet::merge(const std::vector<const uint8_t*>& list, const std::function<void(const uint8_t*)>& visit) const {
+    Before before{length_};
+    // the next certificate of every source: the list and then the runs
+    struct Cursor {
+        const uint8_t* cert;
+        size_t source;
+        size_t pos;
+    };
+    auto later = [&before](const Cursor& a, const Cursor& b) {
+        return before(b.cert, a.cert);
+    };
+    std::priority_queue<Cursor, std::vector<Cursor>, decltype(later)> heap(later);
+    auto next = [this, &list](size_t source, size_t pos) -> const uint8_t* {
+        if (source == 0) {
+            return pos < list.size() ? list[pos] : nullptr;
+        }
+        const Run& run = runs_[source - 1];
+        return pos < run.count ? run.file.data() + pos * length_ : nullptr;
+    };
+    for (size_t source = 0; source <= runs_.size(); source++) {
+        if (const uint8_t* cert = next(source, 0)) {
+            heap.push({cert, source, 0});
+        }
+    }
+
+    const uint8_t* last = nullptr;
+    while (!heap.empty()) {
+        Cursor c = heap.top();
+        heap.pop();
+        // the runs are disjoint, but equal certificates would come one after another
+        if (!last || std::memcmp(last, c.cert, length_) != 0) {
+            visit(c.cert);
+        }
+        last = c.cert;
+        if (const uint8_t* cert = next(c.source, c.pos + 1)) {
+            heap.push({cert, c.source, c.pos + 1});
+        }
+    }
+}
+
+bool ExternalGraphSet::openRun(Run& run) {
+    run.file.open(run.path);
+    if (!run.file.good() || run.file.size() % length_ != 0) {
+        return false;
+    }
+    run.count = run.file.size() / length_;
+    run.index.clear();
+    for (size_t i = 0; i < run.count; i += index_step) {
+        run.index.insert(run.index.end(), run.file.data() + i * length_, run.file.data() + (i + 1) * length_);
+    }
+    return true;
+}
+
+size_t ExternalGraphSet::checkpoint(size_t& first) {
+    std::unique_lock<std::shared_mutex> lock(mut_);
+    if (buffer_.size() && good_) {
+        good_ = spill();
+    }
+    // a failed merge leaves the runs, which are still valid
+    if (good_ && runs_.size() > max_runs) {
+        mergeRuns();
+    }
+    first = next_run_ - runs_.size();
+    return runs_.size();
+}
+
+void ExternalGraphSet::committed() {
+    std::unique_lock<std::shared_mutex> lock(mut_);
+    // in the order of their numbers, so that the ones left by a crash meanwhile are in a row
+    for (const std::string& path : retired_) {
+        std::remove(path.c_str());
+    }
+    retired_.clear();
+}
+
+bool ExternalGraphSet::restore(size_t first, size_t runs) {
+    std::unique_lock<std::shared_mutex> lock(mut_);
+    for (size_t i = first; i < first + runs; i++) {
+        Run run;
+        run.path = prefix_ + ".run" + std::to_string(i);
+        if (!openRun(run)) {
+            return false;
+        }
+        runs_.push_back(std::move(run));
+    }
+    next_run_ = first + runs;
+    // the runs spilled or merged after the checkpoint, the numbers of both follow the checkpoint in a row
+    size_t stale = next_run_;
+    while (std::remove((prefix_ + ".run" + std::to_string(stale)).c_str()) == 0) {
+        stale++;
+    }
+    // the runs merged away before the checkpoint, if the process ended before removing them
+    for (size_t old = first; old > 0 && std::remove((prefix_ + ".run" + std::to_string(old - 1)).c_str()) == 0; old--) {
+    }
+    return true;
+}
+
+void ExternalGraphSet::write(const std::string& path) const {
+    AsyncWriter out;
+    write(out, path);
+}
+
+void ExternalGraphSet::write(AsyncWriter& out, const std::string& path) const {
+    std::unique_lock<std::shared_mutex> lock(mut_);
+    GrHeader header;
+    header.type = GrHeader::graph;
+    header.n = n;
+    header.length = length_;
+    header.sorted = true;
+    GrWriter writer(out, path, header);
+    merge(buffer_.getSorted(), [&writer](const uint8_t* cert) {
+        writer.add(cert);
+    });
+}
+
+void ExternalGraphSet::clear() {
+    std::unique_lock<std::shared_mutex> lock(mut_);
+    for (Run& run : runs_) {
+        run.file.close();
+        std::remove(run.path.c_str());
+    }
+    runs_.clear();
+    for (const std::string& path : retired_) {
+        std::remove(path.c_str());
+    }
+    retired_.clear();
+    next_run_ = 0;
+    buffer_.clear();
+    buffered_ = 0;
+    good_ = true;
+}
@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include "GrFormat.h"
+
+namespace {
+
+const uint8_t magic[4] = {'G', 'R', 'F', 0x1a};
+
+} // namespace
+
+void putLE(uint8_t* out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) {
+        out[i] = (value >> (8 * i)) & 0xff;
+    }
+}
+
+uint64_t getLE(const uint8_t* data, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; i++) {
+        value |= uint64_t(data[i]) << (8 * i);
+    }
+    return value;
+}
+
+void GrHeader::encode(uint8_t* out) const {
+    std::memcpy(out, magic, 4);
+    putLE(out + 4, version, 2);
+    out[6] = type;
+    out[7] = (sorted ? 1 : 0) | (compressed ? 2 : 0);
+    putLE(out + 8, n, 4);
+    putLE(out + 12, length, 4);
+    putLE(out + 16, count, 8);
+    putLE(out + 24, checksum, 8);
+}
+
+bool GrHeader::present(const uint8_t* data, size_t file_size) {
+    if (file_size < size || std::memcmp(data, magic, 4) != 0) {
+        return false;
+    }
+    // a headerless file may begin with the magic by chance, its other fields would hardly fit
+    size_t version = getLE(data + 4, 2);
+    size_t length = getLE(data + 12, 4);
+    bool compressed = data[7] & 2;
+    return version != 0 && version <= current_version && data[6] <= graph && data[7] <= 3 && length != 0 &&
+           (compressed || (file_size - size) % length == 0);
+}
+
+bool GrHeader::decode(const uint8_t* data, size_t file_size) {
+    if (!present(data, file_size)) {
+        return false;
+    }
+    version = getLE(data + 4, 2);
+    type = data[6];
+    sorted = data[7] & 1;
+    compressed = data[7] & 2;
+    n = getLE(data + 8, 4);
+    length = getLE(data + 12, 4);
+    count = getLE(data + 16, 8);
+    checksum = getLE(data + 24, 8);
+    if (version == 0 || version > current_version || length == 0) {
+        return false;
+    }
+    if (compressed) {
+        return true;
+    }
+    // a truncated or extended file
+    return count == (file_size - size) / length && (file_size - size) % length == 0;
+}
+
+uint64_t certificateChecksum(const uint8_t* cert, size_t length) {
+    // 64-bit FNV-1a, fixed by the format: it must not follow changes of the hash tables
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < length; i++) {
+        h ^= cert[i];
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+
+GrWriter::GrWriter(const std::string& path, const GrHeader& header, bool append) : own_(new AsyncWriter()),
+    out_(own_.get()), open_(false), good_(true), header_(header), headerless_(false) {
+    header_.count = 0;
+    header_.checksum = 0;
+    open(path, append);
+}
+
+GrWriter::GrWriter(const std::string& path, size_t length, bool append) : own_(new AsyncWriter()),
+    out_(own_.get()), open_(false), good_(true), headerless_(true) {
+    header_.length = length;
+    open(path, append);
+}
+
+GrWriter::GrWriter(AsyncWriter& out, const std::string& path, const GrHeader& header, bool append) :
+    out_(&out), open_(false), good_(true), header_(header), headerless_(false) {
+    header_.count = 0;
+    header_.checksum = 0;
+    open(path, append);
+}
+
+GrWriter::~GrWriter() {
+    close();
+}
+
+void GrWriter::open(const std::string& path, bool append) {
+    open_ = true;
+    if (append) {
+        // the file may still be queued, and if a queued file failed it may be this one
+        if (!out_->wait()) {
+            open_ = false;
+            good_ = false;
+            return;
+        }
+        std::ifstream stream(path, std::ios::binary | std::ios::ate);
+        if (stream.is_open()) {
+            size_t file_size = stream.tellg();
+            uint8_t data[GrHeader::size];
+            stream.seekg(0);
+            stream.read((char*)data, std::min(file_size, sizeof(data)));
+            GrHeader old;
+            if (old.decode(data, file_size) && !old.compressed && old.length == header_.length &&
+                (headerless_ || (old.type == header_.type && old.n == header_.n))) {
+                // the certificates are added to the counted ones, but they are not sorted anymore
+                bool sorted = header_.sorted && old.count == 0;
+                header_ = old;
+                header_.sorted = sorted;
+                headerless_ = false;
+            } else if (GrHeader::present(data, file_size)) {
+                // a compressed file, a damaged one or one of other structures is left as it is
+                open_ = false;
+                good_ = false;
+                return;
+            } else if (file_size > 0) {
+                headerless_ = true;
+            }
+            if (file_size > 0) {
+                out_->open(path, true);
+                return;
+            }
+        }
+    }
+    out_->open(path);
+    if (!headerless_) {
+        // a place for the header, written once more by close
+        uint8_t data[GrHeader::size];
+        header_.encode(data);
+        out_->write(data, GrHeader::size);
+    }
+}
+
+bool GrWriter::good() const {
+    return good_;
+}
+
+void GrWriter::add(const uint8_t* cert) {
+    if (!open_) {
+        return;
+    }
+    out_->write(cert, header_.length);
+    header_.count++;
+    header_.checksum += certificateChecksum(cert, header_.length);
+}
+
+size_t GrWriter::count() const {
+    return header_.count;
+}
+
+void GrWriter::close() {
+    if (!open_) {
+        return;
+    }
+    open_ = false;
+    if (!headerless_) {
+        uint8_t data[GrHeader::size];
+        header_.encode(data);
+        out_->patch(0, data, GrHeader::size);
+    }
+    out_->finish();
+    if (own_) {
+        good_ = own_->wait();
+    }
+}
@@ -1,12 +1,14 @@
+#include <algorithm>
+
 #include "Graph.h"
 
-Graph::Graph() : Structure(0), e(0) {
+Graph::Graph() : Structure(0), e(0), words_(0) {
 }
 
-Graph::Graph(size_t n) : Structure(n), A(n * n, 0), e(0) {
+Graph::Graph(size_t n) : Structure(n), A(n * n, 0), e(0), words_(wordCount(n)), R(n * words_, 0) {
 }
 
-Graph::Graph(size_t n, const Certificate& cert) : Structure(n, cert), A(n * n, 0), e(0) {
+Graph::Graph(size_t n, const Certificate& cert) : Structure(n, cert), A(n * n, 0), e(0), words_(wordCount(n)), R(n * words_, 0) {
     size_t l = n * (n - 1) / 2;
     if (l % 8 == 0) {
         l >>= 3;
@@ -40,13 +42,45 @@ Graph::Graph(size_t n, const Certificate& cert) : Structure(n, cert), A(n * n, 0
     }
 }
 
+namespace {
+
+Certificate copyCertificate(const GraphView& V) {
+    Certificate cert(Graph::certSize(V.size()));
+    std::copy(V.data(), V.data() + cert.size(), cert.data());
+    return cert;
+}
+
+} // namespace
+
+// the certificate is decoded byte by byte as in Graph(n, cert)
+Graph::Graph(const GraphView& V) : Graph(V.size(), copyCertificate(V)) {
+}
+
 bool Graph::edge(size_t i, size_t j) const {
     return A[n * i + j] != 0;
 }
 
+const word* Graph::row(size_t i) const {
+    return R.data() + i * words_;
+}
+
+size_t Graph::words() const {
+    return words_;
+}
+
+size_t Graph::degree(size_t i) const {
+    size_t d = 0;
+    for (size_t k = 0; k < words_; k++) {
+        d += popcount(R[i * words_ + k]);
+    }
+    return d;
+}
+
 void Graph::resize(size_t m) {
     n = m;
     A.assign(m * m, 0);
+    words_ = wordCount(m);
+    R.assign(m * words_, 0);
     e = 0;
 }
 
@@ -62,11 +96,52 @@ std::vector<size_t> Graph::getDegrees() const {
     return degrees;
 }
 
+// the number of distinct colors, which are replaced by their ranks
+static size_t rankColors(std::vector<size_t>& colors) {
+    std::vector<size_t> sorted = colors;
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    for (size_t& c : colors) {
+        c = std::lower_bound(sorted.begin(), sorted.end(), c) - sorted.begin();
+    }
+    return sorted.size();
+}
+
+std::vector<size_t> Graph::colorClasses() const {
+    std::vector<size_t> colors = getDegrees();
+    size_t classes = rankColors(colors);
+    std::vector<size_t> refined(n);
+    while (classes < n) {
+        // the new color hashes the old one with the multiset of colors of the neighbours,
+        // a collision can only merge classes
+        for (size_t i = 0; i < n; i++) {
+            size_t h = colors[i] * 0x9E3779B97F4A7C15ull;
+            const word* r = row(i);
+            for (size_t k = 0; k < words_; k++) {
+                for (word w = r[k]; w; w &= w - 1) {
+                    size_t c = colors[(k << 6) + __builtin_ctzll(w)] + 1;
+                    h += (c * 0xBF58476D1CE4E5B9ull) ^ (c >> 3) * 0x94D049BB133111EBull;
+                }
+            }
+            refined[i] = h;
+        }
+        size_t count = rankColors(refined);
+        if (count == classes) {
+            break;
+        }
+        classes = count;
+        colors.swap(refined);
+    }
+    return colors;
+}
+
 void Graph::addEdge(size_t i, size_t j) {
     byte c = A[n * i + j];
     if (c == 0) {
         A[n * i + j] = 1;
         A[n * j + i] = 1;
+        R[i * words_ + (j >> 6)] |= word(1) << (j & 63);
+        R[j * words_ + (i >> 6)] |= word(1) << (i & 63);
         e++;
     }
 }
@@ -76,6 +151,8 @@ void Graph::killEdge(size_t i, size_t j) {
     if (c == 1) {
         A[n * i + j] = 0;
         A[n * j + i] = 0;
+        R[i * words_ + (j >> 6)] &= ~(word(1) << (j & 63));
+        R[j * words_ + (i >> 6)] &= ~(word(1) << (i & 63));
         e--;
     }
 }
@@ -163,6 +240,7 @@ size_t Graph::deg() const {
 void Graph::clear() {
     e = 0;
     A.assign(n * n , 0);
+    R.assign(n * words_, 0);
 }
 
 bool Graph::subClique(size_t k) const {
@@ -176,6 +254,104 @@ bool Graph::subClique(size_t k) const {
     return false;
 }
 
+bool Graph::hasIndependentSetThrough(size_t v, size_t k) const {
+    if (k <= 1) {
+        return true;
+    }
+    // the candidates of every level, the first ones are the vertices other than v not adjacent to it
+    thread_local std::vector<word> buffer;
+    buffer.assign(k * words_, 0);
+    word* C = buffer.data();
+    const word* r = row(v);
+    for (size_t w = 0; w < words_; w++) {
+        C[w] = ~r[w];
+    }
+    if (n & 63) {
+        C[words_ - 1] &= (word(1) << (n & 63)) - 1;
+    }
+    C[v >> 6] &= ~(word(1) << (v & 63));
+    return nextIndependent(C, k - 1);
+}
+
+// is there an independent set of k vertices among the candidates C,
+// the candidates of the next level go to the words_ words after C
+bool Graph::nextIndependent(word* C, size_t k) const {
+    if (k == 0) {
+        return true;
+    }
+    size_t count = 0;
+    for (size_t w = 0; w < words_; w++) {
+        count += __builtin_popcountll(C[w]);
+    }
+    word* D = C + words_;
+    for (size_t w = 0; w < words_; w++) {
+        for (word b = C[w]; b; b &= b - 1) {
+            // count is the number of candidates from x on
+            if (count-- < k) {
+                return false;
+            }
+            size_t x = (w << 6) + __builtin_ctzll(b);
+            const word* r = row(x);
+            for (size_t u = 0; u < words_; u++) {
+                D[u] = u < w ? 0 : C[u] & ~r[u];
+            }
+            // only the candidates after x
+            D[w] &= ~((word(2) << (x & 63)) - 1);
+            if (nextIndependent(D, k - 1)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+std::vector<word> Graph::pathMatrix(size_t k) const {
+    if (k == 0 || k > 3) {
+        return {};
+    }
+    if (k == 1) {
+        return R;
+    }
+    // the rows are unions of rows of R, a word at a time
+    std::vector<word> M(n * words_, 0);
+    std::vector<word> T(words_);
+    for (size_t x = 0; x < n; x++) {
+        word* m = M.data() + x * words_;
+        for (size_t a = 0; a < n; a++) {
+            if (!edge(x, a)) {
+                continue;
+            }
+            if (k == 2) {
+                // x a y
+                for (size_t w = 0; w < words_; w++) {
+                    m[w] |= R[a * words_ + w];
+                }
+                continue;
+            }
+            // x a b y with b != x and y != a
+            std::fill(T.begin(), T.end(), 0);
+            for (size_t w = 0; w < words_; w++) {
+                word B = R[a * words_ + w];
+                if (w == (x >> 6)) {
+                    B &= ~(word(1) << (x & 63));
+                }
+                for (; B; B &= B - 1) {
+                    const word* s = row((w << 6) + __builtin_ctzll(B));
+                    for (size_t u = 0; u < words_; u++) {
+                        T[u] |= s[u];
+                    }
+                }
+            }
+            T[a >> 6] &= ~(word(1) << (a & 63));
+            for (size_t w = 0; w < words_; w++) {
+                m[w] |= T[w];
+            }
+        }
+        m[x >> 6] &= ~(word(1) << (x & 63));
+    }
+    return M;
+}
+
 bool Graph::nextS(int level, Perm& Q) const {
     if (level >= Q.size()) {
         return true;
@@ -329,3 +505,12 @@ Graph Q(size_t n) {
     }
     return G;
 }
+
+// the wheel: a cycle on n vertices and a vertex adjacent to all of them
+Graph W(size_t n) {
+    Graph G = C(n) + 1;
+    for (size_t i = 0; i < n; i++) {
+        G.addEdge(i, n);
+    }
+    return G;
+}
@@ -0,0 +1,164 @@
+#include <algorithm>
+
+#include <unistd.h>
+
+#include "Graph.h"
+
+GraphView::GraphView(size_t n, const uint8_t* data) : n(n), data_(data) {
+}
+
+size_t GraphView::size() const {
+    return n;
+}
+
+const uint8_t* GraphView::data() const {
+    return data_;
+}
+
+bool GraphView::edge(size_t i, size_t j) const {
+    if (i == j) {
+        return false;
+    }
+    if (i > j) {
+        std::swap(i, j);
+    }
+    // position of the pair (i, j) in the upper triangle
+    size_t p = i * (2 * n - i - 1) / 2 + j - i - 1;
+    return (data_[p >> 3] >> (7 - (p & 7))) & 1;
+}
+
+size_t GraphView::edges() const {
+    // the unused bits of the last byte are always zero
+    size_t l = Graph::certSize(n);
+    size_t e = 0;
+    for (size_t i = 0; i < l; i++) {
+        e += popcount(data_[i]);
+    }
+    return e;
+}
+
+size_t GraphView::degree(size_t i) const {
+    size_t d = 0;
+    for (size_t j = 0; j < n; j++) {
+        if (edge(i, j)) {
+            d++;
+        }
+    }
+    return d;
+}
+
+size_t GraphView::deg() const {
+    if (n == 0) {
+        return 0;
+    }
+    std::vector<size_t> degrees = getDegrees();
+    size_t d = n - 1;
+    for (size_t x : degrees) {
+        d = std::min(d, x);
+    }
+    return d;
+}
+
+std::vector<size_t> GraphView::getDegrees() const {
+    // a single pass over the upper triangle
+    std::vector<size_t> degrees(n);
+    size_t p = 0;
+    for (size_t i = 0; i + 1 < n; i++) {
+        for (size_t j = i + 1; j < n; j++, p++) {
+            if ((data_[p >> 3] >> (7 - (p & 7))) & 1) {
+                degrees[i]++;
+                degrees[j]++;
+            }
+        }
+    }
+    return degrees;
+}
+
+Bitset GraphView::neighborhood(size_t i) const {
+    Bitset N(n);
+    for (size_t j = 0; j < n; j++) {
+        if (edge(i, j)) {
+            N.set(j);
+        }
+    }
+    return N;
+}
+
+GraphFile::GraphFile(const std::string& path, size_t n) : file_(path), n(n), l(Graph::certSize(n)),
+    good_(false), has_header_(false), offset_(0), count_(0) {
+    if (!file_.good()) {
+        return;
+    }
+    if (GrHeader::present(file_.data(), file_.size())) {
+        has_header_ = true;
+        good_ = header_.decode(file_.data(), file_.size()) && !header_.compressed &&
+                header_.type == GrHeader::graph && header_.n == n && header_.length == l;
+        if (good_) {
+            offset_ = GrHeader::size;
+            count_ = header_.count;
+        }
+    } else {
+        good_ = file_.size() % l == 0;
+        count_ = file_.size() / l;
+    }
+}
+
+bool GraphFile::good() const {
+    return good_;
+}
+
+size_t GraphFile::count() const {
+    return count_;
+}
+
+bool GraphFile::sorted() const {
+    return good_ && has_header_ && header_.sorted;
+}
+
+bool GraphFile::verify() const {
+    if (!good_ || !has_header_) {
+        return good_;
+    }
+    uint64_t checksum = 0;
+    for (size_t i = 0; i < count_; i++) {
+        checksum += certificateChecksum(certificate(i), l);
+    }
+    return checksum == header_.checksum;
+}
+
+GraphView GraphFile::operator[](size_t i) const {
+    return GraphView(n, certificate(i));
+}
+
+const uint8_t* GraphFile::certificate(size_t i) const {
+    return file_.data() + offset_ + i * l;
+}
+
+void GraphFile::load(size_t bytes) const {
+    static const size_t page = sysconf(_SC_PAGESIZE);
+    bytes = std::min(bytes, file_.size());
+    file_.prefetch(0, bytes);
+    // one byte of every page makes the kernel read it now
+    volatile uint8_t sink = 0;
+    for (size_t i = 0; i < bytes; i += page) {
+        sink += file_.data()[i];
+    }
+}
+
+void GraphFile::scan(size_t first, size_t last, const std::function<void(size_t, const GraphView&)>& visit) const {
+    // about a megabyte of certificates per batch
+    const size_t batch = std::max<size_t>(1, (size_t(1) << 20) / l);
+    last = std::min(last, count());
+    if (first < last) {
+        file_.prefetch(offset_ + first * l, std::min(batch, last - first) * l);
+    }
+    for (size_t start = first; start < last; start += batch) {
+        size_t end = std::min(last, start + batch);
+        if (end < last) {
+            file_.prefetch(offset_ + end * l, std::min(batch, last - end) * l);
+        }
+        for (size_t i = start; i < end; i++) {
+            visit(i, GraphView(n, certificate(i)));
+        }
+    }
+}
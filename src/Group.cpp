@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <set>
+
 #include "Group.h"
 
 Group::Group() : Group(1) {
@@ -184,6 +187,71 @@ PermList Group::getGenerators() const {
     return Generators;
 }
 
+// the orbit of the point v, listed in order of discovery
+std::vector<size_t> Group::orbit(size_t v) const {
+    std::vector<size_t> points = {v};
+    std::vector<bool> found(n, false);
+    found[v] = true;
+    for (size_t k = 0; k < points.size(); k++) {
+        for (const Perm& P : Generators) {
+            size_t w = P[points[k]];
+            if (!found[w]) {
+                found[w] = true;
+                points.push_back(w);
+            }
+        }
+    }
+    return points;
+}
+
+// the orbit of the set S of points, listed in order of discovery.
+// Every set is sorted, S must be sorted too
+std::vector<std::vector<size_t>> Group::orbit(const std::vector<size_t>& S) const {
+    std::vector<std::vector<size_t>> sets = {S};
+    std::set<std::vector<size_t>> found = {S};
+    for (size_t k = 0; k < sets.size(); k++) {
+        for (const Perm& P : Generators) {
+            std::vector<size_t> T = sets[k];
+            for (size_t& x : T) {
+                x = P[x];
+            }
+            std::sort(T.begin(), T.end());
+            if (found.insert(T).second) {
+                sets.push_back(std::move(T));
+            }
+        }
+    }
+    return sets;
+}
+
+// the stabilizer of the point v generated by Schreier generators
+Group Group::stabilizer(size_t v) const {
+    Group G(n);
+    // T[w] maps v to w for every w in the orbit of v
+    PermList T(n);
+    std::vector<size_t> points = {v};
+    T[v].id(n);
+    for (size_t k = 0; k < points.size(); k++) {
+        size_t x = points[k];
+        for (const Perm& P : Generators) {
+            size_t y = P[x];
+            if (T[y].empty()) {
+                T[y] = P * T[x];
+                points.push_back(y);
+            }
+        }
+    }
+    for (size_t x : points) {
+        for (const Perm& P : Generators) {
+            Perm Q = Mult(!T[P[x]], P, T[x]);
+            if (!G.contains(Q)) {
+                G.addGen(Q);
+            }
+        }
+    }
+    return G;
+}
+
 bool Group::operator<=(const Group& G) const {
     for (const Perm& P : Generators) {
         if (!G.contains(P)) {
@@ -0,0 +1,103 @@
+#include <algorithm>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "MappedFile.h"
+
+MappedFile::MappedFile() : data_(nullptr), size_(0), good_(false) {
+}
+
+MappedFile::MappedFile(const std::string& path) : MappedFile() {
+    open(path);
+}
+
+MappedFile::MappedFile(MappedFile&& file) : data_(file.data_), size_(file.size_), good_(file.good_) {
+    file.data_ = nullptr;
+    file.size_ = 0;
+    file.good_ = false;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& file) {
+    if (this == &file) {
+        return *this;
+    }
+    close();
+    data_ = file.data_;
+    size_ = file.size_;
+    good_ = file.good_;
+    file.data_ = nullptr;
+    file.size_ = 0;
+    file.good_ = false;
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    size_ = st.st_size;
+    // an empty file can not be mapped, but it is a valid empty file
+    if (size_ > 0) {
+        void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            size_ = 0;
+            return false;
+        }
+        data_ = static_cast<uint8_t*>(p);
+    }
+    ::close(fd);
+    good_ = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) {
+        munmap(data_, size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    good_ = false;
+}
+
+bool MappedFile::good() const {
+    return good_;
+}
+
+const uint8_t* MappedFile::data() const {
+    return data_;
+}
+
+size_t MappedFile::size() const {
+    return size_;
+}
+
+void MappedFile::adviseSequential() const {
+    if (data_) {
+        madvise(data_, size_, MADV_SEQUENTIAL);
+    }
+}
+
+void MappedFile::prefetch(size_t offset, size_t length) const {
+    static const size_t page = sysconf(_SC_PAGESIZE);
+    if (!data_ || offset >= size_) {
+        return;
+    }
+    size_t start = offset & ~(page - 1);
+    size_t end = std::min(size_, offset + length);
+    madvise(data_ + start, end - start, MADV_WILLNEED);
+}
@@ -0,0 +1,297 @@
+#include <algorithm>
+
+#include "Matcher.h"
+
+SubgraphMatcher::SubgraphMatcher() {
+}
+
+SubgraphMatcher::SubgraphMatcher(const Graph& pattern) : P(pattern) {
+    size_t n = P.size();
+    Group A = P.aut();
+
+    global = makePlan({}, A, false);
+
+    std::vector<bool> seen(n, false);
+    for (size_t v = 0; v < n; v++) {
+        if (seen[v]) {
+            continue;
+        }
+        for (size_t w : A.orbit(v)) {
+            seen[w] = true;
+        }
+        Group Av = A.stabilizer(v);
+        vertex.push_back(makePlan({v}, Av, false));
+        cone.push_back(makePlan({v}, Av, true));
+    }
+
+    // orbits on ordered pairs (a, b) of adjacent vertices
+    PermList gens = A.getGenerators();
+    std::vector<bool> found(n * n, false);
+    for (size_t a = 0; a < n; a++) {
+        for (size_t b = 0; b < n; b++) {
+            if (!P.edge(a, b) || found[a * n + b]) {
+                continue;
+            }
+            std::vector<size_t> arcs = {a * n + b};
+            found[a * n + b] = true;
+            for (size_t k = 0; k < arcs.size(); k++) {
+                for (const Perm& Q : gens) {
+                    size_t c = Q[arcs[k] / n] * n + Q[arcs[k] % n];
+                    if (!found[c]) {
+                        found[c] = true;
+                        arcs.push_back(c);
+                    }
+                }
+            }
+            arc.push_back(makePlan({a, b}, A.stabilizer(a).stabilizer(b), false));
+        }
+    }
+}
+
+size_t SubgraphMatcher::size() const {
+    return P.size();
+}
+
+const Graph& SubgraphMatcher::pattern() const {
+    return P;
+}
+
+// A must be the subgroup of Aut(P) fixing every vertex of fixed.
+// If outside is true, the first fixed vertex is not in the host graph
+// and its edges put no constraints on the search
+SubgraphMatcher::Plan SubgraphMatcher::makePlan(const std::vector<size_t>& fixed, Group A, bool outside) const {
+    size_t n = P.size();
+    Plan plan;
+    plan.order = fixed;
+    plan.fixed = fixed.size();
+
+    Graph Q = P;
+    if (outside) {
+        for (size_t v = 0; v < n; v++) {
+            Q.killEdge(fixed[0], v);
+        }
+    }
+
+    // greedy order: the vertex with most mapped neighbours, then with largest degree
+    std::vector<size_t> level(n, n);
+    for (size_t l = 0; l < fixed.size(); l++) {
+        level[fixed[l]] = l;
+    }
+    while (plan.order.size() < n) {
+        size_t best = n;
+        size_t best_links = 0;
+        size_t best_degree = 0;
+        for (size_t v = 0; v < n; v++) {
+            if (level[v] < n) {
+                continue;
+            }
+            size_t links = 0;
+            for (size_t u : plan.order) {
+                if (Q.edge(u, v)) {
+                    links++;
+                }
+            }
+            size_t d = Q.degree(v);
+            if (best == n || links > best_links || (links == best_links && d > best_degree)) {
+                best = v;
+                best_links = links;
+                best_degree = d;
+            }
+        }
+        level[best] = plan.order.size();
+        plan.order.push_back(best);
+    }
+
+    plan.adjacent.resize(n);
+    plan.above.resize(n);
+    plan.degree.resize(n);
+    for (size_t l = 0; l < n; l++) {
+        plan.degree[l] = Q.degree(plan.order[l]);
+        for (size_t k = 0; k < l; k++) {
+            if (Q.edge(plan.order[k], plan.order[l])) {
+                plan.adjacent[l].push_back(k);
+            }
+        }
+    }
+
+    // symmetry breaking: every remaining automorphism moving the vertex v
+    // is excluded by asking the image of v to be the smallest in its orbit
+    for (size_t l = plan.fixed; l < n && A.order() > 1; l++) {
+        size_t v = plan.order[l];
+        std::vector<size_t> orbit = A.orbit(v);
+        if (orbit.size() == 1) {
+            continue;
+        }
+        for (size_t w : orbit) {
+            if (w != v) {
+                // every vertex w of the orbit is placed after v, since A fixes all earlier vertices
+                plan.above[level[w]].push_back(l);
+            }
+        }
+        A = A.stabilizer(v);
+    }
+    return plan;
+}
+
+bool SubgraphMatcher::search(const Plan& plan, const Graph& G, std::vector<size_t>& g,
+                             const std::function<bool(const std::vector<size_t>&)>* visit) const {
+    size_t W = G.words();
+    // candidate sets of every level and the set of used vertices
+    thread_local std::vector<word> buffer;
+    buffer.assign((plan.order.size() + 1) * W, 0);
+    word* used = buffer.data() + plan.order.size() * W;
+    for (size_t l = 0; l < plan.fixed; l++) {
+        // a fixed vertex may also lie outside of G
+        if (g[l] < G.size()) {
+            used[g[l] >> 6] |= word(1) << (g[l] & 63);
+        }
+    }
+    return extend(plan, G, plan.fixed, g, buffer.data(), used, visit);
+}
+
+// returns true if the search must stop
+bool SubgraphMatcher::extend(const Plan& plan, const Graph& G, size_t level, std::vector<size_t>& g, word* cand, word* used,
+                             const std::function<bool(const std::vector<size_t>&)>* visit) const {
+    size_t n = G.size();
+    size_t W = G.words();
+    if (level == plan.order.size()) {
+        if (!visit) {
+            return true;
+        }
+        thread_local std::vector<size_t> image;
+        image.resize(plan.order.size());
+        for (size_t l = 0; l < plan.order.size(); l++) {
+            image[plan.order[l]] = g[l];
+        }
+        return !(*visit)(image);
+    }
+
+    word* C = cand + level * W;
+    const std::vector<size_t>& adjacent = plan.adjacent[level];
+    if (adjacent.empty()) {
+        for (size_t k = 0; k < W; k++) {
+            C[k] = ~word(0);
+        }
+        if (n & 63) {
+            C[W - 1] = (word(1) << (n & 63)) - 1;
+        }
+    } else {
+        const word* r = G.row(g[adjacent[0]]);
+        for (size_t k = 0; k < W; k++) {
+            C[k] = r[k];
+        }
+        for (size_t i = 1; i < adjacent.size(); i++) {
+            r = G.row(g[adjacent[i]]);
+            for (size_t k = 0; k < W; k++) {
+                C[k] &= r[k];
+            }
+        }
+    }
+    for (size_t k = 0; k < W; k++) {
+        C[k] &= ~used[k];
+    }
+
+    // the image must be larger than the images of the levels in above
+    size_t start = 0;
+    for (size_t l : plan.above[level]) {
+        start = std::max(start, g[l] + 1);
+    }
+
+    size_t d = plan.degree[level];
+    for (size_t k = start >> 6; k < W; k++) {
+        word w = C[k];
+        if (k == (start >> 6)) {
+            w &= ~word(0) << (start & 63);
+        }
+        while (w) {
+            size_t x = (k << 6) + __builtin_ctzll(w);
+            w &= w - 1;
+            if (G.degree(x) < d) {
+                continue;
+            }
+            g[level] = x;
+            used[k] |= word(1) << (x & 63);
+            bool stop = extend(plan, G, level + 1, g, cand, used, visit);
+            used[k] &= ~(word(1) << (x & 63));
+            if (stop) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool SubgraphMatcher::exists(const Graph& G) const {
+    if (P.size() > G.size()) {
+        return false;
+    }
+    std::vector<size_t> g(P.size());
+    return search(global, G, g, nullptr);
+}
+
+bool SubgraphMatcher::existsThrough(const Graph& G, size_t u, size_t v) const {
+    if (P.size() > G.size()) {
+        return false;
+    }
+    std::vector<size_t> g(P.size());
+    for (const Plan& plan : arc) {
+        g[0] = u;
+        g[1] = v;
+        if (search(plan, G, g, nullptr)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SubgraphMatcher::enumerate(const Graph& G, size_t v, const std::function<bool(const std::vector<size_t>&)>& visit) const {
+    if (P.size() > G.size()) {
+        return;
+    }
+    std::vector<size_t> g(P.size());
+    for (const Plan& plan : vertex) {
+        g[0] = v;
+        if (G.degree(v) < plan.degree[0]) {
+            continue;
+        }
+        if (search(plan, G, g, &visit)) {
+            return;
+        }
+    }
+}
+
+void SubgraphMatcher::visitForbiddenSets(const Graph& G, const std::function<void(const std::vector<size_t>&)>& visit) const {
+    if (P.size() > G.size() + 1) {
+        return;
+    }
+    std::vector<size_t> g(P.size());
+    std::vector<size_t> S;
+    size_t p = 0;
+    std::function<bool(const std::vector<size_t>&)> copy = [&](const std::vector<size_t>& image) {
+        S.clear();
+        for (size_t q = 0; q < P.size(); q++) {
+            if (P.edge(p, q)) {
+                S.push_back(image[q]);
+            }
+        }
+        std::sort(S.begin(), S.end());
+        visit(S);
+        return true;
+    };
+    for (const Plan& plan : cone) {
+        p = plan.order[0];
+        // the new vertex gets the index G.size()
+        g[0] = G.size();
+        search(plan, G, g, &copy);
+    }
+}
+
+std::vector<std::vector<size_t>> SubgraphMatcher::forbiddenSets(const Graph& G) const {
+    std::vector<std::vector<size_t>> sets;
+    visitForbiddenSets(G, [&](const std::vector<size_t>& S) {
+        sets.push_back(S);
+    });
+    std::sort(sets.begin(), sets.end());
+    sets.erase(std::unique(sets.begin(), sets.end()), sets.end());
+    return sets;
+}
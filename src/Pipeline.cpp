@@ -0,0 +1,28 @@
+#include "Pipeline.h"
+
+ReadAhead::ReadAhead(const std::vector<std::string>& paths, size_t n, size_t ahead, size_t window) :
+    queue_(std::max<size_t>(1, ahead)) {
+    thread_ = std::thread([this, paths, n, window] {
+        for (const std::string& path : paths) {
+            std::unique_ptr<const GraphFile> file(new GraphFile(path, n));
+            if (file->good()) {
+                file->load(window);
+            }
+            if (!queue_.push(std::move(file))) {
+                return;
+            }
+        }
+        queue_.close();
+    });
+}
+
+ReadAhead::~ReadAhead() {
+    queue_.close();
+    thread_.join();
+}
+
+std::unique_ptr<const GraphFile> ReadAhead::next() {
+    std::unique_ptr<const GraphFile> file;
+    queue_.pop(file);
+    return file;
+}
@@ -0,0 +1,278 @@
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <queue>
+#include <dirent.h>
+
+#include "Graph.h"
+#include "SortedFile.h"
+
+SortedFile::SortedFile(const std::string& path, size_t length) : file_(path), length_(length), count_(0),
+    good_(false), has_header_(false), sorted_(false), data_(file_.data()) {
+    if (!file_.good()) {
+        return;
+    }
+    if (GrHeader::present(file_.data(), file_.size())) {
+        has_header_ = true;
+        good_ = header_.decode(file_.data(), file_.size()) && !header_.compressed && header_.length == length_;
+        if (good_) {
+            data_ += GrHeader::size;
+            count_ = header_.count;
+        }
+    } else {
+        good_ = file_.size() % length_ == 0;
+        count_ = file_.size() / length_;
+    }
+    // a file without the flag is read once to see its order
+    sorted_ = good_ && ((has_header_ && header_.sorted) || isSorted());
+}
+
+bool SortedFile::good() const {
+    return good_;
+}
+
+bool SortedFile::hasHeader() const {
+    return has_header_;
+}
+
+const GrHeader& SortedFile::header() const {
+    return header_;
+}
+
+size_t SortedFile::size() const {
+    return count_;
+}
+
+size_t SortedFile::length() const {
+    return length_;
+}
+
+const uint8_t* SortedFile::at(size_t i) const {
+    return data_ + i * length_;
+}
+
+bool SortedFile::contains(const uint8_t* cert) const {
+    if (!sorted_) {
+        return false;
+    }
+    size_t lo = 0;
+    size_t hi = count_;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int c = std::memcmp(at(mid), cert, length_);
+        if (c == 0) {
+            return true;
+        }
+        // larger certificates come first
+        if (c > 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return false;
+}
+
+bool SortedFile::contains(const Structure& s) const {
+    return s.certificate().size() == length_ && contains(s.certificate().data());
+}
+
+bool SortedFile::isSorted() const {
+    for (size_t i = 1; i < count_; i++) {
+        if (std::memcmp(at(i - 1), at(i), length_) <= 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SortedFile::sorted() const {
+    return sorted_;
+}
+
+namespace {
+
+// a writer of a sorted file like the input, with a header if it has one
+std::unique_ptr<GrWriter> makeWriter(const SortedFile& input, const std::string& output) {
+    if (!input.hasHeader()) {
+        return std::make_unique<GrWriter>(output, input.length());
+    }
+    GrHeader header = input.header();
+    header.sorted = true;
+    return std::make_unique<GrWriter>(output, header);
+}
+
+// the file is complete once the writer is closed
+bool finished(const std::unique_ptr<GrWriter>& writer) {
+    if (!writer) {
+        return true;
+    }
+    writer->close();
+    return writer->good();
+}
+
+void report(bool* good, bool value) {
+    if (good) {
+        *good = value;
+    }
+}
+
+} // namespace
+
+size_t mergeSorted(const std::vector<std::string>& inputs, const std::string& output, size_t length, bool* good) {
+    std::vector<SortedFile> files;
+    files.reserve(inputs.size());
+    for (const std::string& path : inputs) {
+        files.emplace_back(path, length);
+        if (!files.back().sorted()) {
+            report(good, false);
+            return 0;
+        }
+    }
+
+    // the next certificate of every file, the largest one on the top
+    struct Cursor {
+        const uint8_t* cert;
+        size_t file;
+        size_t pos;
+    };
+    auto later = [length](const Cursor& a, const Cursor& b) {
+        return std::memcmp(a.cert, b.cert, length) < 0;
+    };
+    std::priority_queue<Cursor, std::vector<Cursor>, decltype(later)> heap(later);
+    for (size_t f = 0; f < files.size(); f++) {
+        if (files[f].size()) {
+            heap.push({files[f].at(0), f, 0});
+        }
+    }
+
+    std::unique_ptr<GrWriter> writer = files.empty() ? nullptr : makeWriter(files[0], output);
+    size_t count = 0;
+    const uint8_t* last = nullptr;
+    while (!heap.empty()) {
+        Cursor c = heap.top();
+        heap.pop();
+        if (!last || std::memcmp(last, c.cert, length) != 0) {
+            writer->add(c.cert);
+            count++;
+        }
+        last = c.cert;
+        if (c.pos + 1 < files[c.file].size()) {
+            heap.push({files[c.file].at(c.pos + 1), c.file, c.pos + 1});
+        }
+    }
+    report(good, finished(writer));
+    return count;
+}
+
+namespace {
+
+// walks over a and b together and writes the certificates of a
+// which are in b if common is true, and which are not in b otherwise
+size_t filterSorted(const std::string& a, const std::string& b, const std::string& output, size_t length, bool common, bool* good) {
+    SortedFile A(a, length);
+    SortedFile B(b, length);
+    if (!A.sorted() || !B.sorted()) {
+        report(good, false);
+        return 0;
+    }
+    std::unique_ptr<GrWriter> writer = makeWriter(A, output);
+    size_t count = 0;
+    size_t j = 0;
+    const uint8_t* last = nullptr;
+    for (size_t i = 0; i < A.size(); i++) {
+        const uint8_t* cert = A.at(i);
+        if (last && std::memcmp(last, cert, length) == 0) {
+            continue;
+        }
+        last = cert;
+        while (j < B.size() && std::memcmp(B.at(j), cert, length) > 0) {
+            j++;
+        }
+        bool found = j < B.size() && std::memcmp(B.at(j), cert, length) == 0;
+        if (found == common) {
+            writer->add(cert);
+            count++;
+        }
+    }
+    report(good, finished(writer));
+    return count;
+}
+
+} // namespace
+
+size_t differenceSorted(const std::string& a, const std::string& b, const std::string& output, size_t length, bool* good) {
+    return filterSorted(a, b, output, length, false, good);
+}
+
+size_t intersectSorted(const std::string& a, const std::string& b, const std::string& output, size_t length, bool* good) {
+    return filterSorted(a, b, output, length, true, good);
+}
+
+size_t sortFile(const std::string& input, const std::string& output, size_t n, bool* good) {
+    GraphFile file(input, n);
+    if (!file.good()) {
+        report(good, false);
+        return 0;
+    }
+    size_t length = Graph::certSize(n);
+    GraphSet graphs(n, true);
+    for (size_t i = 0; i < file.count(); i++) {
+        Certificate cert(length);
+        std::copy(file.certificate(i), file.certificate(i) + length, cert.data());
+        // the graph keeps the certificate it is built from
+        graphs.insert(Graph(n, cert));
+    }
+    report(good, graphs.writeSorted(output));
+    return graphs.size();
+}
+
+size_t mergeShards(const std::string& dir, const std::vector<std::string>& shards, size_t n, bool* good) {
+    report(good, true);
+    std::map<std::string, std::vector<std::string>> parts;
+    for (const std::string& shard : shards) {
+        DIR* d = opendir(shard.c_str());
+        if (!d) {
+            report(good, false);
+            return 0;
+        }
+        while (dirent* entry = readdir(d)) {
+            std::string name = entry->d_name;
+            if (name.size() > 3 && name.substr(name.size() - 3) == ".gr" && GraphFile(shard + "/" + name, n).good()) {
+                parts[name].push_back(shard + "/" + name);
+            }
+        }
+        closedir(d);
+    }
+
+    size_t total = 0;
+    for (auto& part : parts) {
+        const std::string output = dir + "/" + part.first;
+        std::vector<std::string>& inputs = part.second;
+        if (GraphFile(output, n).good()) {
+            inputs.push_back(output);
+        }
+        // the canonical mode writes the graphs as they are found
+        std::vector<std::string> temporary;
+        bool done = true;
+        for (std::string& input : inputs) {
+            if (done && !GraphFile(input, n).sorted()) {
+                temporary.push_back(output + ".sort" + std::to_string(temporary.size()));
+                sortFile(input, temporary.back(), n, &done);
+                input = temporary.back();
+            }
+        }
+        // the output replaces the old file in dir, which is one of the inputs, once it is complete
+        size_t count = done ? mergeSorted(inputs, output, Graph::certSize(n), &done) : 0;
+        for (const std::string& path : temporary) {
+            std::remove(path.c_str());
+        }
+        if (!done) {
+            report(good, false);
+            return total;
+        }
+        total += count;
+    }
+    return total;
+}
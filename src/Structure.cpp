@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <cstring>
 
 #include "Structure.h"
 
@@ -78,6 +79,7 @@ Certifier::~Certifier() {
 Structure& Structure::certify() {
     Certifier certifier(this);
     cert = getCertificate(certifier.B);
+    canon = certifier.B;
     auto_group = std::move(certifier.Top->G);
     return *this;
 }
@@ -89,6 +91,38 @@ Group Structure::aut() {
     return *auto_group;
 }
 
+const Certificate& Structure::certificate() const {
+    return cert;
+}
+
+Perm Structure::canonicalLabeling() {
+    if (!auto_group) {
+        certify();
+    }
+    return canon;
+}
+
+bool Structure::isCanonicalAugmentation(size_t v, const std::vector<size_t>& eligible) {
+    if (!auto_group) {
+        certify();
+    }
+    std::vector<size_t> position(n);
+    for (size_t i = 0; i < n; i++) {
+        position[canon[i]] = i;
+    }
+    size_t m = eligible[0];
+    for (size_t x : eligible) {
+        if (position[x] > position[m]) {
+            m = x;
+        }
+    }
+    if (m == v) {
+        return true;
+    }
+    std::vector<size_t> orbit = auto_group->orbit(m);
+    return std::find(orbit.begin(), orbit.end(), v) != orbit.end();
+}
+
 SearchNode::SearchNode(size_t n, Certifier* crt) : G(nullptr), Next(nullptr), OnBestPath(false), CellOrbits(n), crt(crt) {
 };
 
@@ -544,41 +578,134 @@ Finish:
     }
 }
 
+StructSet::StructSet(size_t length) {
+    reset(length);
+}
+
+void StructSet::reset(size_t length) {
+    length_ = length;
+    for (Shard& sh : shards_) {
+        std::lock_guard<std::mutex> lock(sh.mut);
+        sh.data.clear();
+        sh.table = CertificateTable(length);
+    }
+}
+
+// a shard is chosen by the top bits of the mixed hash
+size_t StructSet::shardIndex(size_t hash) {
+    return (hash * 0x9E3779B97F4A7C15ull) >> 58;
+}
+
 void StructSet::insert(const Structure& s) {
-    std::lock_guard<std::mutex> lock(mut_);
-    data_.insert(s.cert);
+    insertIfAbsent(s);
 }
 
-void StructSet::write(const std::string& path, bool append) const {
-    std::lock_guard<std::mutex> lock(mut_);
-    std::fstream stream;
-    if (append) {
-        stream.open(path, std::ios::app | std::ios::out | std::ios::binary);
-    } else {
-        stream.open(path, std::ios::out | std::ios::binary);
+bool StructSet::insertIfAbsent(const Structure& s) {
+    size_t h = std::hash<Certificate>()(s.cert);
+    Shard& sh = shards_[shardIndex(h)];
+    std::lock_guard<std::mutex> lock(sh.mut);
+    if (length_) {
+        // an uncertified structure or a certificate of another length can not be in the table
+        return s.cert.size() == length_ && sh.table.insert(s.cert.data(), h);
     }
-    for (const Certificate& cert : data_) {
-        Structure::writeStruct(stream, cert);
+    return sh.data.insert(s.cert).second;
+}
+
+bool StructSet::write(const std::string& path, bool append) const {
+    return writeFile(nullptr, path, append, false);
+}
+
+bool StructSet::write(AsyncWriter& out, const std::string& path, bool append) const {
+    return writeFile(&out, path, append, false);
+}
+
+bool StructSet::writeSorted(const std::string& path) const {
+    return writeFile(nullptr, path, false, true);
+}
+
+bool StructSet::describe(GrHeader&) const {
+    return false;
+}
+
+bool StructSet::writeFile(AsyncWriter* out, const std::string& path, bool append, bool sorted) const {
+    std::vector<std::pair<const uint8_t*, size_t>> certs;
+    for (const Shard& sh : shards_) {
+        std::lock_guard<std::mutex> lock(sh.mut);
+        for (const Certificate& cert : sh.data) {
+            certs.emplace_back(cert.data(), cert.size());
+        }
+        for (size_t i = 0; i < sh.table.capacity(); i++) {
+            if (sh.table.occupied(i)) {
+                certs.emplace_back(sh.table.at(i), length_);
+            }
+        }
+    }
+    if (sorted) {
+        // the order of compareCertificates: longer ones first, then larger bytes first
+        std::sort(certs.begin(), certs.end(), [](const std::pair<const uint8_t*, size_t>& a, const std::pair<const uint8_t*, size_t>& b) {
+            if (a.second != b.second) {
+                return a.second > b.second;
+            }
+            return std::memcmp(a.first, b.first, a.second) > 0;
+        });
+    }
+
+    GrHeader header;
+    if (describe(header)) {
+        header.sorted = sorted;
+        std::unique_ptr<GrWriter> writer = out ? std::make_unique<GrWriter>(*out, path, header, append)
+                                               : std::make_unique<GrWriter>(path, header, append);
+        for (const auto& [data, size] : certs) {
+            writer->add(data);
+        }
+        writer->close();
+        return writer->good();
+    }
+    // the certificates may differ in length, so they are written as one headerless stream
+    std::unique_ptr<AsyncWriter> own;
+    if (!out) {
+        own = std::make_unique<AsyncWriter>();
+        out = own.get();
     }
-    stream.close();
+    // a queued file which failed may be the one appended to
+    if (append && !out->wait()) {
+        return false;
+    }
+    out->open(path, append);
+    for (const auto& [data, size] : certs) {
+        out->write(data, size);
+    }
+    out->finish();
+    return !own || own->wait();
 }
 
 size_t StructSet::size() const {
-    std::lock_guard<std::mutex> lock(mut_);
-    return data_.size();
+    size_t s = 0;
+    for (const Shard& sh : shards_) {
+        std::lock_guard<std::mutex> lock(sh.mut);
+        s += sh.data.size() + sh.table.size();
+    }
+    return s;
 }
 
 bool StructSet::empty() const {
-    std::lock_guard<std::mutex> lock(mut_);
-    return data_.empty();
+    return size() == 0;
 }
 
 void StructSet::clear() {
-    std::lock_guard<std::mutex> lock(mut_);
-    data_.clear();
+    for (Shard& sh : shards_) {
+        std::lock_guard<std::mutex> lock(sh.mut);
+        sh.data.clear();
+        sh.table.clear();
+    }
 }
 
 bool StructSet::contains(const Structure& s) const {
-    std::lock_guard<std::mutex> lock(mut_);
-    return data_.count(s.cert);
+    size_t h = std::hash<Certificate>()(s.cert);
+    const Shard& sh = shards_[shardIndex(h)];
+    std::lock_guard<std::mutex> lock(sh.mut);
+    if (length_) {
+        return s.cert.size() == length_ && sh.table.contains(s.cert.data(), h);
+    }
+    return sh.data.count(s.cert);
 }
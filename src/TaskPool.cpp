@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <chrono>
+
+#include "TaskPool.h"
+
+namespace {
+
+thread_local const TaskPool* current_pool = nullptr;
+thread_local size_t current_worker = 0;
+// the number of tasks the thread is running, nested ones run during a wait
+thread_local size_t running = 0;
+
+} // namespace
+
+TaskPool::Group::Group(TaskPool& pool) : pool_(pool), pending_(0) {
+}
+
+TaskPool::Group::~Group() {
+    wait();
+}
+
+void TaskPool::Group::run(std::function<void()> task) {
+    pending_++;
+    pool_.push({std::move(task), this});
+}
+
+void TaskPool::Group::wait() {
+    size_t index = pool_.worker();
+    bool inside = index < pool_.size();
+    while (pending_ > 0) {
+        // a worker helps instead of blocking, so nested groups can not deadlock
+        if (inside && pool_.runOne(index)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(pool_.mut_);
+        pool_.cv_.wait(lock, [this, inside] {
+            return pending_ == 0 || (inside && pool_.queued_ > 0);
+        });
+    }
+}
+
+TaskPool::TaskPool(size_t threads) : next_(0), queued_(0), stop_(false) {
+    threads = std::max<size_t>(1, threads);
+    for (size_t i = 0; i < threads; i++) {
+        workers_.emplace_back(new Worker());
+    }
+    for (size_t i = 0; i < threads; i++) {
+        threads_.emplace_back(&TaskPool::loop, this, i);
+    }
+}
+
+TaskPool::~TaskPool() {
+    {
+        std::lock_guard<std::mutex> lock(mut_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+size_t TaskPool::size() const {
+    return workers_.size();
+}
+
+size_t TaskPool::worker() const {
+    return current_pool == this ? current_worker : size();
+}
+
+std::vector<double> TaskPool::busyTimes() const {
+    std::vector<double> times;
+    for (const auto& w : workers_) {
+        times.push_back(w->busy * 1e-9);
+    }
+    return times;
+}
+
+void TaskPool::resetBusyTimes() {
+    for (const auto& w : workers_) {
+        w->busy = 0;
+    }
+}
+
+void TaskPool::push(Task task) {
+    size_t index = worker();
+    if (index == size()) {
+        index = next_++ % size();
+    }
+    {
+        std::lock_guard<std::mutex> lock(workers_[index]->mut);
+        workers_[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mut_);
+        queued_++;
+    }
+    cv_.notify_all();
+}
+
+bool TaskPool::runOne(size_t index) {
+    Task task;
+    bool found = false;
+    {
+        Worker& own = *workers_[index];
+        std::lock_guard<std::mutex> lock(own.mut);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            found = true;
+        }
+    }
+    for (size_t k = 1; k < size() && !found; k++) {
+        Worker& other = *workers_[(index + k) % size()];
+        std::lock_guard<std::mutex> lock(other.mut);
+        if (!other.tasks.empty()) {
+            task = std::move(other.tasks.front());
+            other.tasks.pop_front();
+            found = true;
+        }
+    }
+    if (!found) {
+        return false;
+    }
+    queued_--;
+    auto start = std::chrono::steady_clock::now();
+    running++;
+    task.run();
+    running--;
+    if (running == 0) {
+        std::chrono::nanoseconds time = std::chrono::steady_clock::now() - start;
+        workers_[index]->busy += time.count();
+    }
+    if (--task.group->pending_ == 0) {
+        std::lock_guard<std::mutex> lock(mut_);
+        cv_.notify_all();
+    }
+    return true;
+}
+
+void TaskPool::loop(size_t index) {
+    current_pool = this;
+    current_worker = index;
+    for (;;) {
+        if (runOne(index)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mut_);
+        cv_.wait(lock, [this] { return stop_ || queued_ > 0; });
+        if (stop_ && queued_ == 0) {
+            return;
+        }
+    }
+}
+
+ChunkCursor::ChunkCursor(size_t count, size_t workers, size_t min_chunk) : next_(0), count_(count),
+    divisor_(2 * std::max<size_t>(1, workers)), min_chunk_(std::max<size_t>(1, min_chunk)) {
+}
+
+size_t ChunkCursor::position() const {
+    return std::min(next_.load(), count_);
+}
+
+bool ChunkCursor::next(size_t& first, size_t& last) {
+    size_t current = next_.load();
+    for (;;) {
+        if (current >= count_) {
+            return false;
+        }
+        size_t chunk = std::max(min_chunk_, (count_ - current) / divisor_);
+        size_t end = std::min(count_, current + chunk);
+        if (next_.compare_exchange_weak(current, end)) {
+            first = current;
+            last = end;
+            return true;
+        }
+    }
+}
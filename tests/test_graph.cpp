@@ -1,4 +1,20 @@
+#include <csignal>
+#include <fstream>
+#include <set>
+
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "AsyncWriter.h"
+#include "Checkpoint.h"
+#include "CompressedFile.h"
+#include "ExternalGraphSet.h"
 #include "Graph.h"
+#include "GraphView.h"
+#include "Pipeline.h"
+#include "SortedFile.h"
+#include "TaskPool.h"
 
 #include "catch.hpp"
 
@@ -123,3 +139,951 @@ TEST_CASE("automorphism groups") {
     }
 
 }
+
+TEST_CASE("independent sets through a vertex") {
+    std::vector<Graph> graphs = {C(7), P(9), Q(3), K(3, 4), C(5) + K(4), C(12) + P(5)};
+    for (const Graph& G : graphs) {
+        for (size_t v = 0; v < G.size(); v += 3) {
+            // the graph induced by the non-neighbours of v
+            std::vector<size_t> far;
+            for (size_t x = 0; x < G.size(); ++x) {
+                if (x != v && !G.edge(v, x)) {
+                    far.push_back(x);
+                }
+            }
+            Graph H(far.size());
+            for (size_t i = 0; i < far.size(); ++i) {
+                for (size_t j = i + 1; j < far.size(); ++j) {
+                    if (G.edge(far[i], far[j])) {
+                        H.addEdge(i, j);
+                    }
+                }
+            }
+            for (size_t k = 1; k <= 5; ++k) {
+                REQUIRE(G.hasIndependentSetThrough(v, k) == (k == 1 || H.subClique(k - 1)));
+            }
+        }
+    }
+    // graphs of more than one word
+    REQUIRE(C(70).hasIndependentSetThrough(69, 5));
+    REQUIRE(P(65).hasIndependentSetThrough(64, 5));
+    REQUIRE((K(40) + K(40)).hasIndependentSetThrough(79, 2));
+    REQUIRE(!(K(40) + K(40)).hasIndependentSetThrough(79, 3));
+    REQUIRE(!(K(40) + K(30) + K(20)).hasIndependentSetThrough(5, 4));
+}
+
+TEST_CASE("path matrices") {
+    Graph G = C(8);
+    G.addEdge(0, 4);
+    G.addEdge(1, 5);
+    // a graph of two words per row, with paths across the word boundary
+    Graph H = G + P(60);
+    H.addEdge(0, 66);
+    H.addEdge(3, 65);
+    H.addEdge(62, 67);
+    H.addEdge(10, 64);
+    std::vector<Graph> graphs = {G, Q(3), K(3, 4), P(6) + K(3), H};
+    for (const Graph& G : graphs) {
+        size_t n = G.size();
+        size_t W = G.words();
+        for (size_t k = 1; k <= 3; ++k) {
+            std::vector<word> M = G.pathMatrix(k);
+            REQUIRE(M.size() == n * W);
+            for (size_t x = 0; x < n; ++x) {
+                for (size_t y = 0; y < n; ++y) {
+                    // a path x a b y of k edges with distinct vertices
+                    bool path = false;
+                    for (size_t a = 0; a < n; ++a) {
+                        for (size_t b = 0; b < n; ++b) {
+                            if (k == 1) {
+                                path = path || G.edge(x, y);
+                            } else if (k == 2) {
+                                path = path || (x != y && G.edge(x, a) && G.edge(a, y));
+                            } else {
+                                path = path || (x != y && x != b && a != y && G.edge(x, a) && G.edge(a, b) && G.edge(b, y));
+                            }
+                        }
+                    }
+                    REQUIRE(((M[x * W + (y >> 6)] >> (y & 63)) & 1) == path);
+                }
+            }
+        }
+        // longer paths are not supported
+        REQUIRE(G.pathMatrix(0).empty());
+        REQUIRE(G.pathMatrix(4).empty());
+    }
+    // in a long cycle a path of k edges joins the vertices at distance k
+    G = C(70);
+    for (size_t k = 1; k <= 3; ++k) {
+        std::vector<word> M = G.pathMatrix(k);
+        for (size_t x = 0; x < 70; ++x) {
+            for (size_t y = 0; y < 70; ++y) {
+                bool path = (x + k) % 70 == y || (y + k) % 70 == x;
+                REQUIRE(((M[x * 2 + (y >> 6)] >> (y & 63)) & 1) == path);
+            }
+        }
+    }
+}
+
+TEST_CASE("color classes") {
+    for (size_t i = 3; i < 20; ++i) {
+        std::vector<size_t> colors = C(i).colorClasses();
+        REQUIRE(std::set<size_t>(colors.begin(), colors.end()).size() == 1);
+    }
+    for (size_t i = 2; i < 20; ++i) {
+        // the classes of a path are the pairs of vertices at equal distance from an end
+        std::vector<size_t> colors = P(i).colorClasses();
+        REQUIRE(std::set<size_t>(colors.begin(), colors.end()).size() == (i + 1) / 2);
+        for (size_t j = 0; j < i; ++j) {
+            REQUIRE(colors[j] == colors[i - 1 - j]);
+        }
+    }
+}
+
+TEST_CASE("canonical augmentation") {
+    // all graphs on n vertices are built from the graphs on n - 1 vertices by joining
+    // a new vertex to one set from every orbit, with no isomorphism checks between them
+    std::vector<size_t> counts = {1, 2, 4, 11, 34, 156, 1044};
+    std::vector<Graph> level = {Graph(1)};
+    for (size_t n = 2; n <= counts.size(); ++n) {
+        std::vector<Graph> next;
+        GraphSet graphs(n);
+        std::vector<size_t> eligible(n);
+        for (size_t i = 0; i < n; ++i) {
+            eligible[i] = i;
+        }
+        for (Graph& H : level) {
+            Group A = H.aut();
+            std::set<std::vector<size_t>> seen;
+            for (size_t mask = 0; mask < (size_t(1) << (n - 1)); ++mask) {
+                std::vector<size_t> S;
+                for (size_t i = 0; i + 1 < n; ++i) {
+                    if ((mask >> i) & 1) {
+                        S.push_back(i);
+                    }
+                }
+                if (seen.count(S)) {
+                    continue;
+                }
+                for (std::vector<size_t>& T : A.orbit(S)) {
+                    seen.insert(T);
+                }
+                Graph G = H + 1;
+                for (size_t i : S) {
+                    G.addEdge(i, n - 1);
+                }
+                if (G.isCanonicalAugmentation(n - 1, eligible)) {
+                    graphs.insert(G);
+                    next.push_back(G);
+                }
+            }
+        }
+        REQUIRE(next.size() == counts[n - 1]);
+        REQUIRE(graphs.size() == next.size());
+        level = std::move(next);
+    }
+}
+
+TEST_CASE("certificates") {
+    // short certificates are kept inline, long ones on the heap
+    for (size_t m : {0, 1, 31, 32, 33, 1000, 70000}) {
+        Certificate C(m);
+        for (size_t i = 0; i < m; ++i) {
+            C[i] = i * 7;
+        }
+        Certificate D = C;
+        REQUIRE(D.size() == m);
+        REQUIRE(D == C);
+        Certificate E = std::move(D);
+        REQUIRE(E == C);
+        REQUIRE(D.size() == 0);
+        for (size_t k : {0, 5, 32, 40}) {
+            Certificate F(k);
+            F = C;
+            REQUIRE(F == C);
+            Certificate G(k);
+            G = std::move(F);
+            REQUIRE(G == C);
+        }
+    }
+
+    // the order of sorted files: longer certificates first, then larger bytes first
+    std::vector<Certificate> order = {Cert("bb"), Cert("ba"), Cert("ab"), Cert("\x01\xff"), Cert("z"), Cert("a"), Certificate(0)};
+    for (size_t i = 0; i < order.size(); ++i) {
+        for (size_t j = 0; j < order.size(); ++j) {
+            int c = compareCertificates(order[i], order[j]);
+            REQUIRE((i < j ? c < 0 : i > j ? c > 0 : c == 0));
+        }
+    }
+    REQUIRE(Certificate(0) == Certificate(0));
+}
+
+TEST_CASE("flat graph sets") {
+    for (size_t n = 1; n <= 7; ++n) {
+        GraphSet nodes(n);
+        GraphSet flat(n, true);
+        // graphs on n vertices with edges among the first ten pairs, isomorphic ones come many times
+        for (size_t mask = 0; mask < 1024 && mask < (size_t(1) << (n * (n - 1) / 2)); ++mask) {
+            Graph G(n);
+            size_t b = 0;
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t j = i + 1; j < n; ++j, ++b) {
+                    if (b < 10 && ((mask >> b) & 1)) {
+                        G.addEdge(i, j);
+                    }
+                }
+            }
+            G.certify();
+            bool added = nodes.insertIfAbsent(G);
+            REQUIRE(flat.insertIfAbsent(G) == added);
+            REQUIRE(flat.contains(G));
+        }
+        REQUIRE(flat.size() == nodes.size());
+        std::vector<Certificate> a = nodes.getList();
+        std::vector<Certificate> b;
+        for (auto it = flat.begin(); it != flat.end(); ++it) {
+            Graph G = *it;
+            G.certify();
+            REQUIRE(flat.contains(G));
+            b.push_back(G.certificate());
+        }
+        auto less = [](const Certificate& C, const Certificate& D) {
+            return compareCertificates(C, D) < 0;
+        };
+        std::sort(a.begin(), a.end(), less);
+        std::sort(b.begin(), b.end(), less);
+        REQUIRE(a == b);
+        // the sorted pointers lead to the same certificates in the same order
+        for (const GraphSet* set : {&nodes, &flat}) {
+            std::vector<const uint8_t*> sorted = set->getSorted();
+            REQUIRE(sorted.size() == a.size());
+            for (size_t i = 0; i < a.size(); ++i) {
+                REQUIRE(std::memcmp(sorted[i], a[i].data(), a[i].size()) == 0);
+            }
+        }
+    }
+
+    // an uncertified graph or a graph of another size is rejected by the flat table
+    GraphSet flat(6, true);
+    Graph G = C(6);
+    REQUIRE(!flat.insertIfAbsent(G));
+    REQUIRE(!flat.contains(G));
+    G = C(7);
+    G.certify();
+    REQUIRE(!flat.insertIfAbsent(G));
+    REQUIRE(!flat.contains(G));
+    REQUIRE(flat.empty());
+}
+
+TEST_CASE("external graph sets") {
+    for (size_t n = 5; n <= 7; ++n) {
+        GraphSet all(n);
+        // a budget of a few certificates makes many runs
+        ExternalGraphSet external(n, 64, "external_test");
+        for (size_t mask = 0; mask < 1024 && mask < (size_t(1) << (n * (n - 1) / 2)); ++mask) {
+            Graph G(n);
+            size_t b = 0;
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t j = i + 1; j < n; ++j, ++b) {
+                    if (b < 10 && ((mask >> b) & 1)) {
+                        G.addEdge(i, j);
+                    }
+                }
+            }
+            G.certify();
+            bool added = all.insertIfAbsent(G);
+            REQUIRE(external.insertIfAbsent(G) == added);
+            REQUIRE(external.contains(G));
+        }
+        REQUIRE(external.runs() > 1);
+        REQUIRE(external.size() == all.size());
+
+        external.write("external_test.gr");
+        std::vector<Certificate> a = all.getList();
+        std::sort(a.begin(), a.end(), [](const Certificate& C, const Certificate& D) {
+            return compareCertificates(C, D) < 0;
+        });
+        std::vector<Certificate> b;
+        GraphFile file("external_test.gr", n);
+        REQUIRE(file.sorted());
+        for (size_t i = 0; i < file.count(); ++i) {
+            Certificate cert(Graph::certSize(n));
+            std::copy(file.certificate(i), file.certificate(i) + cert.size(), cert.data());
+            b.push_back(cert);
+        }
+        REQUIRE(a == b);
+        std::remove("external_test.gr");
+
+        // a new set takes the runs of a checkpoint, as after a crash of the process.
+        // The many runs of the small budget are merged into one
+        size_t spilled = external.runs();
+        size_t first = 0;
+        size_t runs = external.checkpoint(first);
+        REQUIRE(runs == (spilled >= 8 ? 1 : external.runs()));
+        REQUIRE(runs <= 8);
+        REQUIRE(runs == external.runs());
+        REQUIRE(external.size() == all.size());
+        // the merged run has a new name and the old runs stay till the checkpoint is saved
+        REQUIRE(first + runs > spilled);
+        REQUIRE(MappedFile("external_test.run0").good() == (first == 0 || spilled >= 8));
+        external.committed();
+        REQUIRE(MappedFile("external_test.run0").good() == (first == 0));
+        // a run spilled after the checkpoint and one merged away before it are left by a crash
+        std::vector<std::string> stale = {"external_test.run" + std::to_string(first + runs)};
+        if (first > 0) {
+            stale.push_back("external_test.run" + std::to_string(first - 1));
+        }
+        for (const std::string& path : stale) {
+            std::fclose(std::fopen(path.c_str(), "wb"));
+        }
+        ExternalGraphSet restored(n, 64, "external_test");
+        REQUIRE(restored.restore(first, runs));
+        REQUIRE(restored.size() == all.size());
+        for (const Certificate& cert : a) {
+            REQUIRE(restored.contains(Graph(n, cert)));
+        }
+        for (const std::string& path : stale) {
+            REQUIRE(!std::ifstream(path).is_open());
+        }
+        ExternalGraphSet missing(n, 64, "external_missing");
+        REQUIRE(!missing.restore(0, 1));
+
+        // runs which can not be written leave the graphs in memory
+        ExternalGraphSet unwritten(n, 64, "no_such_directory/external_test");
+        for (const Certificate& cert : a) {
+            unwritten.insert(Graph(n, cert));
+        }
+        REQUIRE(!unwritten.good());
+        REQUIRE(unwritten.runs() == 0);
+        REQUIRE(unwritten.size() == all.size());
+        unwritten.checkpoint(first);
+        REQUIRE(!unwritten.good());
+        unwritten.write("external_test.gr");
+        REQUIRE(GraphFile("external_test.gr", n).count() == all.size());
+        std::remove("external_test.gr");
+
+        external.clear();
+        REQUIRE(external.empty());
+        REQUIRE(external.runs() == 0);
+    }
+}
+
+TEST_CASE("sorted files") {
+    const size_t n = 6;
+    const size_t length = Graph::certSize(n);
+    GraphSet A(n, true);
+    GraphSet B(n);
+    GraphSet all(n);
+    for (size_t mask = 0; mask < 1024; ++mask) {
+        Graph G(n);
+        size_t b = 0;
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = i + 1; j < n; ++j, ++b) {
+                if (b < 10 && ((mask >> b) & 1)) {
+                    G.addEdge(i, j);
+                }
+            }
+        }
+        G.certify();
+        all.insert(G);
+        if (G.edges() % 2 == 0 || G.edges() == 5) {
+            A.insert(G);
+        }
+        if (G.edges() % 3 == 0) {
+            B.insert(G);
+        }
+    }
+    A.writeSorted("sorted_a.gr");
+    B.writeSorted("sorted_b.gr");
+    SortedFile FA("sorted_a.gr", length);
+    SortedFile FB("sorted_b.gr", length);
+    REQUIRE(FA.good());
+    REQUIRE(FA.isSorted());
+    REQUIRE(FB.isSorted());
+    REQUIRE(FA.size() == A.size());
+    for (auto it = all.begin(); it != all.end(); ++it) {
+        Graph G = *it;
+        G.certify();
+        REQUIRE(FA.contains(G) == A.contains(G));
+        REQUIRE(FB.contains(G) == B.contains(G));
+    }
+
+    size_t common = 0;
+    for (auto it = A.begin(); it != A.end(); ++it) {
+        Graph G = *it;
+        G.certify();
+        common += B.contains(G);
+    }
+    REQUIRE(mergeSorted({"sorted_a.gr", "sorted_b.gr", "sorted_a.gr"}, "sorted_u.gr", length) == A.size() + B.size() - common);
+    REQUIRE(SortedFile("sorted_u.gr", length).isSorted());
+    REQUIRE(differenceSorted("sorted_a.gr", "sorted_b.gr", "sorted_d.gr", length) == A.size() - common);
+    REQUIRE(intersectSorted("sorted_a.gr", "sorted_b.gr", "sorted_c.gr", length) == common);
+    SortedFile D("sorted_d.gr", length);
+    for (size_t i = 0; i < D.size(); ++i) {
+        REQUIRE(FA.contains(D.at(i)));
+        REQUIRE(!FB.contains(D.at(i)));
+    }
+    // the same file read in ranges as a GraphFile
+    GraphFile file("sorted_a.gr", n);
+    REQUIRE(file.count() == FA.size());
+    size_t seen = 0;
+    for (size_t first = 0; first < file.count(); first += 100) {
+        file.scan(first, first + 100, [&](size_t i, const GraphView& V) {
+            REQUIRE(i == seen++);
+            REQUIRE(V.data() == file.certificate(i));
+            REQUIRE(std::equal(V.data(), V.data() + length, FA.at(i)));
+        });
+    }
+    REQUIRE(seen == file.count());
+
+    // a file of a generator is not searched or merged, even with a header telling its length
+    GrHeader header = FA.header();
+    header.sorted = false;
+    GrWriter writer("sorted_r.gr", header);
+    for (size_t i = FA.size(); i-- > 0;) {
+        writer.add(FA.at(i));
+    }
+    writer.close();
+    SortedFile R("sorted_r.gr", length);
+    REQUIRE(R.good());
+    REQUIRE(!R.sorted());
+    REQUIRE(!R.contains(FA.at(0)));
+    bool good = true;
+    mergeSorted({"sorted_a.gr", "sorted_r.gr"}, "sorted_u.gr", length, &good);
+    REQUIRE(!good);
+    good = true;
+    intersectSorted("sorted_r.gr", "sorted_a.gr", "sorted_c.gr", length, &good);
+    REQUIRE(!good);
+    // the order of a file without the flag is checked
+    REQUIRE(FA.sorted());
+    GrWriter unflagged("sorted_r.gr", header);
+    for (size_t i = 0; i < FA.size(); i++) {
+        unflagged.add(FA.at(i));
+    }
+    unflagged.close();
+    REQUIRE(SortedFile("sorted_r.gr", length).sorted());
+    for (const char* path : {"sorted_a.gr", "sorted_b.gr", "sorted_u.gr", "sorted_d.gr", "sorted_c.gr", "sorted_r.gr"}) {
+        std::remove(path);
+    }
+}
+
+TEST_CASE("merging shards") {
+    const size_t n = 6;
+    mkdir("merge_test", 0755);
+    mkdir("merge_test/shard0-2", 0755);
+    mkdir("merge_test/shard1-2", 0755);
+    GraphSet S(n);
+    // the file merged before
+    S.insert(Graph(n).certify());
+    S.writeSorted("merge_test/a.gr");
+    S.clear();
+    S.insert(C(6).certify());
+    S.insert(P(6).certify());
+    S.writeSorted("merge_test/shard0-2/a.gr");
+    S.clear();
+    // a part of the canonical mode, not sorted, and P(6) once more
+    for (Graph G : {P(6), K(3, 3), K(6)}) {
+        S.insert(G.certify());
+    }
+    S.write("merge_test/shard1-2/a.gr");
+    REQUIRE(!GraphFile("merge_test/shard1-2/a.gr", n).sorted());
+    S.clear();
+    S.insert(W(6).certify());
+    S.write("merge_test/shard1-2/b.gr");
+
+    bool good = false;
+    REQUIRE(mergeShards("merge_test", {"merge_test/shard0-2", "merge_test/shard1-2"}, n, &good) == 6);
+    REQUIRE(good);
+    SortedFile a("merge_test/a.gr", Graph::certSize(n));
+    REQUIRE(a.size() == 5);
+    REQUIRE(a.header().sorted);
+    REQUIRE(a.isSorted());
+    REQUIRE(GraphFile("merge_test/a.gr", n).verify());
+    for (Graph G : {Graph(n), C(6), P(6), K(3, 3), K(6)}) {
+        REQUIRE(a.contains(G.certify()));
+    }
+    REQUIRE(GraphFile("merge_test/b.gr", n).count() == 1);
+    REQUIRE(!MappedFile("merge_test/a.gr.tmp").good());
+    REQUIRE(!MappedFile("merge_test/a.gr.sort0").good());
+
+    // a missing shard or output directory stops the merge
+    mergeShards("merge_test", {"merge_test/shard2-2"}, n, &good);
+    REQUIRE(!good);
+    good = true;
+    mergeShards("merge_test/missing", {"merge_test/shard0-2"}, n, &good);
+    REQUIRE(!good);
+    REQUIRE(!MappedFile("merge_test/missing/a.gr").good());
+
+    for (const char* path : {"merge_test/a.gr", "merge_test/b.gr", "merge_test/shard0-2/a.gr",
+                             "merge_test/shard1-2/a.gr", "merge_test/shard1-2/b.gr"}) {
+        std::remove(path);
+    }
+    for (const char* path : {"merge_test/shard0-2", "merge_test/shard1-2", "merge_test"}) {
+        rmdir(path);
+    }
+}
+
+TEST_CASE("gr headers") {
+    // the checksum is part of the format and must never change
+    const uint8_t a[] = {'a'};
+    REQUIRE(certificateChecksum(a, 1) == 0xAF63DC4C8601EC8Cull);
+    REQUIRE(certificateChecksum(a, 0) == 0xCBF29CE484222325ull);
+
+    const size_t n = 6;
+    const size_t length = Graph::certSize(n);
+    GraphSet S(n);
+    for (Graph G : {C(6), P(6), K(3, 3), K(6), Graph(6)}) {
+        S.insert(G.certify());
+    }
+    S.write("header_test.gr");
+    GraphFile file("header_test.gr", n);
+    REQUIRE(file.good());
+    REQUIRE(file.count() == 5);
+    REQUIRE(!file.sorted());
+    REQUIRE(file.verify());
+    // a wrong number of vertices with the same certificate length
+    REQUIRE(Graph::certSize(5) == length);
+    REQUIRE(!GraphFile("header_test.gr", 5).good());
+    // and nothing of it is appended
+    GraphSet five(5);
+    five.insert(C(5).certify());
+    REQUIRE(!five.write("header_test.gr", true));
+    REQUIRE(GraphFile("header_test.gr", n).count() == 5);
+
+    // appending updates the count and the checksum
+    GraphSet T(n);
+    Graph H = C(3) + C(3);
+    T.insert(H.certify());
+    T.insert(K(6).certify());
+    T.write("header_test.gr", true);
+    GraphFile appended("header_test.gr", n);
+    REQUIRE(appended.count() == 7);
+    REQUIRE(appended.verify());
+
+    std::fstream stream("header_test.gr", std::ios::in | std::ios::out | std::ios::binary);
+    stream.seekp(GrHeader::size + length);
+    stream.put(char(0x55));
+    stream.close();
+    REQUIRE(GraphFile("header_test.gr", n).good());
+    REQUIRE(!GraphFile("header_test.gr", n).verify());
+
+    // a truncated file
+    MappedFile mapped("header_test.gr");
+    std::vector<uint8_t> bytes(mapped.data(), mapped.data() + mapped.size());
+    mapped.close();
+    stream.open("header_test.gr", std::ios::out | std::ios::binary);
+    stream.write((const char*)bytes.data(), bytes.size() - length);
+    stream.close();
+    REQUIRE(!GraphFile("header_test.gr", n).good());
+
+    // a headerless file of older versions
+    stream.open("header_test.gr", std::ios::out | std::ios::binary);
+    stream.write((const char*)bytes.data() + GrHeader::size, 3 * length);
+    stream.close();
+    GraphFile old("header_test.gr", n);
+    REQUIRE(old.good());
+    REQUIRE(old.count() == 3);
+    REQUIRE(old.verify());
+    // and it stays headerless when graphs are appended
+    T.write("header_test.gr", true);
+    REQUIRE(GraphFile("header_test.gr", n).count() == 5);
+    // a headerless file whose first certificate begins with the magic
+    const size_t m = 10;
+    std::vector<uint8_t> magic(10 * Graph::certSize(m), 0);
+    std::copy_n("GRF\x1a", 4, magic.begin());
+    stream.open("magic_test.gr", std::ios::out | std::ios::binary);
+    stream.write((const char*)magic.data(), magic.size());
+    stream.close();
+    REQUIRE(GraphFile("magic_test.gr", m).good());
+    REQUIRE(GraphFile("magic_test.gr", m).count() == 10);
+    REQUIRE(SortedFile("magic_test.gr", Graph::certSize(m)).size() == 10);
+    std::remove("magic_test.gr");
+    std::remove("header_test.gr");
+}
+
+TEST_CASE("compressed files") {
+    const size_t n = 7;
+    const size_t length = Graph::certSize(n);
+    GraphSet A(n, true);
+    GraphSet all(n);
+    for (size_t mask = 0; mask < 4096; ++mask) {
+        Graph G(n);
+        size_t b = 0;
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = i + 1; j < n; ++j, ++b) {
+                if (b < 12 && ((mask >> b) & 1)) {
+                    G.addEdge(i, j);
+                }
+            }
+        }
+        G.certify();
+        all.insert(G);
+        if (G.edges() % 2 == 0) {
+            A.insert(G);
+        }
+    }
+    A.writeSorted("compressed_test.gr");
+    SortedFile sorted("compressed_test.gr", length);
+
+    // small blocks to get many of them
+    GrHeader header = sorted.header();
+    CompressedWriter writer("compressed_test.grz", header, 16);
+    for (size_t i = 0; i < sorted.size(); i++) {
+        writer.add(sorted.at(i));
+    }
+    writer.close();
+    CompressedFile file("compressed_test.grz");
+    REQUIRE(file.good());
+    REQUIRE(file.count() == A.size());
+    REQUIRE(file.blocks() == (A.size() + 15) / 16);
+    REQUIRE(file.header().sorted);
+    REQUIRE(file.verify());
+
+    size_t count = 0;
+    file.scan([&](size_t i, const uint8_t* cert) {
+        REQUIRE(std::equal(cert, cert + length, sorted.at(i)));
+        count++;
+    });
+    REQUIRE(count == A.size());
+    // any block alone
+    std::vector<uint8_t> block;
+    file.decodeBlock(file.blocks() / 2, block);
+    REQUIRE(block.size() == 16 * length);
+    REQUIRE(std::equal(block.begin(), block.end(), sorted.at(file.blocks() / 2 * 16)));
+    for (auto it = all.begin(); it != all.end(); ++it) {
+        Graph G = *it;
+        REQUIRE(file.contains(G.certify().certificate().data()) == A.contains(G));
+    }
+    // an unsorted file is not searched
+    GrHeader unsorted = header;
+    unsorted.sorted = false;
+    CompressedWriter shuffled("compressed_unsorted.grz", unsorted, 16);
+    for (size_t i = sorted.size(); i-- > 0;) {
+        shuffled.add(sorted.at(i));
+    }
+    shuffled.close();
+    CompressedFile reversed("compressed_unsorted.grz");
+    REQUIRE(reversed.good());
+    REQUIRE(reversed.verify());
+    REQUIRE(!reversed.contains(sorted.at(0)));
+    std::remove("compressed_unsorted.grz");
+
+    // the round trip through the tool functions gives the same file
+    bool good = false;
+    REQUIRE(compressGr("compressed_test.gr", "compressed_test.grz", n, &good) == A.size());
+    REQUIRE(good);
+    REQUIRE(decompressGr("compressed_test.grz", "compressed_copy.gr", &good) == A.size());
+    REQUIRE(good);
+    // a file which can not be written is reported and leaves nothing behind
+    compressGr("compressed_test.gr", "no_such_directory/compressed_test.grz", n, &good);
+    REQUIRE(!good);
+    REQUIRE(!MappedFile("no_such_directory/compressed_test.grz").good());
+    decompressGr("compressed_test.gr", "compressed_copy2.gr", &good);
+    REQUIRE(!good);
+    REQUIRE(!MappedFile("compressed_copy2.gr").good());
+    SortedFile copy("compressed_copy.gr", length);
+    REQUIRE(copy.header().sorted);
+    REQUIRE(copy.header().checksum == sorted.header().checksum);
+    for (size_t i = 0; i < copy.size(); i++) {
+        REQUIRE(std::equal(copy.at(i), copy.at(i) + length, sorted.at(i)));
+    }
+    // compressed files are not read as plain ones
+    REQUIRE(!GraphFile("compressed_test.grz", n).good());
+    // and nothing is appended to them
+    size_t size = MappedFile("compressed_test.grz").size();
+    GrWriter appending("compressed_test.grz", header, true);
+    appending.add(sorted.at(0));
+    appending.close();
+    REQUIRE(!appending.good());
+    REQUIRE(MappedFile("compressed_test.grz").size() == size);
+    REQUIRE(CompressedFile("compressed_test.grz").verify());
+    // nor to a file of another certificate length
+    GrHeader other = header;
+    other.length = length + 1;
+    GrWriter longer("compressed_test.gr", other, true);
+    std::vector<uint8_t> cert(length + 1, 0);
+    longer.add(cert.data());
+    longer.close();
+    REQUIRE(!longer.good());
+    REQUIRE(GraphFile("compressed_test.gr", n).count() == A.size());
+
+    // the first certificate of the last block
+    std::fstream stream("compressed_test.grz", std::ios::in | std::ios::out | std::ios::binary);
+    stream.seekp(-std::streamoff(length), std::ios::end);
+    stream.put(char(0x55));
+    stream.close();
+    REQUIRE(CompressedFile("compressed_test.grz").good());
+    REQUIRE(!CompressedFile("compressed_test.grz").verify());
+    std::remove("compressed_test.gr");
+    std::remove("compressed_test.grz");
+    std::remove("compressed_copy.gr");
+}
+
+TEST_CASE("async writer") {
+    // tiny blocks, so that the writer waits for the background thread
+    AsyncWriter out(false, 16);
+    std::vector<uint8_t> data(1000);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = i * 7;
+    }
+    for (int f = 0; f < 3; f++) {
+        out.open("async_test" + std::to_string(f) + ".bin");
+        out.write(data.data(), data.size());
+        out.write(data.data(), f);
+        out.patch(0, data.data() + 10, 3);
+        out.finish();
+    }
+    REQUIRE(out.wait());
+    for (int f = 0; f < 3; f++) {
+        std::string path = "async_test" + std::to_string(f) + ".bin";
+        MappedFile file(path);
+        REQUIRE(file.size() == data.size() + f);
+        REQUIRE(std::equal(data.begin() + 10, data.begin() + 13, file.data()));
+        REQUIRE(std::equal(data.begin() + 3, data.end(), file.data() + 3));
+        REQUIRE(!MappedFile(path + ".tmp").good());
+        file.close();
+        std::remove(path.c_str());
+    }
+    out.open("no_such_directory/async_test.bin");
+    out.write(data.data(), data.size());
+    out.finish();
+    REQUIRE(!out.wait());
+    REQUIRE(out.wait());
+
+    // a file which is not written completely does not replace the old one.
+    // The limit of the file size makes the writes fail with EFBIG
+    {
+        std::ofstream old("async_test.bin", std::ios::binary);
+        old << "old";
+    }
+    std::signal(SIGXFSZ, SIG_IGN);
+    rlimit limit;
+    getrlimit(RLIMIT_FSIZE, &limit);
+    rlimit small = limit;
+    small.rlim_cur = 100;
+    setrlimit(RLIMIT_FSIZE, &small);
+    out.open("async_test.bin");
+    out.write(data.data(), data.size());
+    out.finish();
+    bool written = out.wait();
+    setrlimit(RLIMIT_FSIZE, &limit);
+    REQUIRE(!written);
+    REQUIRE(MappedFile("async_test.bin").size() == 3);
+    REQUIRE(!MappedFile("async_test.bin.tmp").good());
+    std::remove("async_test.bin");
+
+    // the set may be cleared while its file is written
+    GraphSet S(6);
+    for (Graph G : {C(6), P(6), K(3, 3), K(6)}) {
+        S.insert(G.certify());
+    }
+    S.write(out, "async_test.gr");
+    S.clear();
+    S.insert(Graph(6).certify());
+    S.write(out, "async_test.gr", true);
+    S.clear();
+    REQUIRE(out.wait());
+    GraphFile file("async_test.gr", 6);
+    REQUIRE(file.good());
+    REQUIRE(file.count() == 5);
+    REQUIRE(file.verify());
+    // nothing is appended after a failure of a queued file, which is reported once
+    out.open("no_such_directory/async_test.bin");
+    out.finish();
+    S.insert(C(6).certify());
+    REQUIRE(!S.write(out, "async_test.gr", true));
+    REQUIRE(out.wait());
+    REQUIRE(GraphFile("async_test.gr", 6).count() == 5);
+    std::remove("async_test.gr");
+}
+
+TEST_CASE("checkpoints") {
+    AsyncWriter out;
+    Checkpoint saved("checkpoint_test");
+    REQUIRE(saved.empty());
+    saved.add("parent", {3, 100, 250});
+    saved.add("target", {7, 2, 1, 0});
+    saved.add("parent", {4, 0, 18});
+    saved.add("writing", {});
+    saved.write(out);
+    REQUIRE(out.wait());
+
+    Checkpoint read("checkpoint_test");
+    REQUIRE(!read.empty());
+    REQUIRE(read.get("parent") == std::vector<std::vector<size_t>>{{3, 100, 250}, {4, 0, 18}});
+    REQUIRE(read.get("target") == std::vector<std::vector<size_t>>{{7, 2, 1, 0}});
+    REQUIRE(read.get("writing") == std::vector<std::vector<size_t>>{{}});
+    REQUIRE(read.get("part").empty());
+    read.remove();
+    REQUIRE(read.empty());
+    REQUIRE(Checkpoint("checkpoint_test").empty());
+
+    CheckpointClock off(0);
+    REQUIRE(!off.enabled());
+    REQUIRE(!off.due());
+    CheckpointClock clock(0.001);
+    REQUIRE(clock.enabled());
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    REQUIRE(clock.due());
+    REQUIRE(clock.paused());
+    clock.restart();
+    REQUIRE(!clock.paused());
+}
+
+TEST_CASE("task pool") {
+    TaskPool pool(4);
+    REQUIRE(pool.size() == 4);
+    REQUIRE(pool.worker() == 4);
+    std::atomic<size_t> sum(0);
+    std::atomic<size_t> wrong(0);
+    {
+        TaskPool::Group group(pool);
+        for (size_t i = 0; i < 1000; i++) {
+            group.run([i, &pool, &sum, &wrong] {
+                if (pool.worker() >= pool.size()) {
+                    wrong++;
+                }
+                sum += i;
+            });
+        }
+        group.wait();
+        REQUIRE(sum == 999 * 1000 / 2);
+    }
+    // nested groups wait inside of tasks, more of them than workers
+    sum = 0;
+    TaskPool::Group outer(pool);
+    for (size_t i = 0; i < 16; i++) {
+        outer.run([&pool, &sum] {
+            TaskPool::Group inner(pool);
+            for (size_t j = 0; j < 100; j++) {
+                inner.run([&sum] {
+                    sum++;
+                });
+            }
+            inner.wait();
+            sum += 1000;
+        });
+    }
+    outer.wait();
+    REQUIRE(sum == 16 * 1100);
+    REQUIRE(wrong == 0);
+    REQUIRE(pool.busyTimes().size() == 4);
+
+    // every index is handed out once, in chunks getting smaller
+    ChunkCursor cursor(10000, 4, 8);
+    std::vector<std::atomic<int>> seen(10000);
+    TaskPool::Group group(pool);
+    for (size_t t = 0; t < 4; t++) {
+        group.run([&cursor, &seen, &wrong] {
+            size_t first, last, previous = 10000;
+            while (cursor.next(first, last)) {
+                if (last - first > previous || (last - first < 8 && last != 10000)) {
+                    wrong++;
+                }
+                previous = last - first;
+                for (size_t i = first; i < last; i++) {
+                    seen[i]++;
+                }
+            }
+        });
+    }
+    group.wait();
+    REQUIRE(wrong == 0);
+    REQUIRE(std::all_of(seen.begin(), seen.end(), [](const std::atomic<int>& s) { return s == 1; }));
+    size_t first, last;
+    REQUIRE(!cursor.next(first, last));
+    REQUIRE(cursor.position() == 10000);
+}
+
+TEST_CASE("pipeline") {
+    // a queue of two slots: the producer waits for the consumer, the order is kept
+    BoundedQueue<size_t> queue(2);
+    std::thread producer([&queue] {
+        for (size_t i = 0; i < 1000; i++) {
+            queue.push(i);
+        }
+        queue.close();
+    });
+    size_t value, expected = 0;
+    while (queue.pop(value)) {
+        REQUIRE(value == expected);
+        expected++;
+    }
+    producer.join();
+    REQUIRE(expected == 1000);
+    REQUIRE(!queue.push(0));
+
+    std::vector<std::string> paths;
+    for (int f = 0; f < 4; f++) {
+        GraphSet S(5);
+        for (int i = 0; i <= f; i++) {
+            Graph G(5);
+            for (int j = 0; j < i; j++) {
+                G.addEdge(j, j + 1);
+            }
+            S.insert(G.certify());
+        }
+        paths.push_back("pipeline_test" + std::to_string(f) + ".gr");
+        S.write(paths.back());
+    }
+    paths.insert(paths.begin() + 2, "no_such_file.gr");
+    {
+        ReadAhead reader(paths, 5, 1);
+        for (size_t i = 0; i < paths.size(); i++) {
+            std::unique_ptr<const GraphFile> file = reader.next();
+            REQUIRE(file);
+            if (i == 2) {
+                REQUIRE(!file->good());
+            } else {
+                REQUIRE(file->good());
+                REQUIRE(file->count() == i + (i < 2));
+            }
+        }
+        REQUIRE(!reader.next());
+    }
+    // the reader may be left before the last file
+    ReadAhead(paths, 5, 1).next();
+    // a window of one byte reads only the beginning, the files are whole anyway
+    {
+        ReadAhead reader(paths, 5, 2, 1);
+        reader.next();
+        std::unique_ptr<const GraphFile> file = reader.next();
+        size_t count = 0;
+        file->scan(0, file->count(), [&](size_t, const GraphView&) {
+            count++;
+        });
+        REQUIRE(count == 2);
+    }
+    for (const std::string& path : paths) {
+        std::remove(path.c_str());
+    }
+}
+
+TEST_CASE("graph views") {
+    std::vector<Graph> graphs = {C(7), P(9), K(3, 4), Q(3), K(5) + C(4), Graph(1), Graph(2)};
+    for (Graph& G : graphs) {
+        size_t n = G.size();
+        GraphSet S(n);
+        S.insert(G.certify());
+        for (auto it = S.begin(); it != S.end(); ++it) {
+            Graph H = *it;
+            GraphView V = it.view();
+            REQUIRE(V.size() == n);
+            REQUIRE(V.edges() == H.edges());
+            REQUIRE(V.edges() == G.edges());
+            REQUIRE(V.deg() == H.deg());
+            REQUIRE(V.getDegrees() == H.getDegrees());
+            for (size_t i = 0; i < n; ++i) {
+                Bitset N = V.neighborhood(i);
+                REQUIRE(N.count() == V.degree(i));
+                for (size_t j = 0; j < n; ++j) {
+                    REQUIRE(V.edge(i, j) == H.edge(i, j));
+                    REQUIRE(N.test(j) == H.edge(i, j));
+                }
+            }
+            Graph F(V);
+            F.certify();
+            REQUIRE(isomorphic(F, G));
+        }
+    }
+}
@@ -59,3 +59,12 @@ TEST_CASE("Normal subgroups") {
         REQUIRE((A(n) << S(n)));
     }
 }
+
+TEST_CASE("Orbits") {
+    for (int n = 3; n <= 20; ++n) {
+        REQUIRE(Z(n).orbit(0).size() == n);
+        REQUIRE(Z(n).orbit(std::vector<size_t>{0, 1}).size() == n);
+        REQUIRE(D(n).orbit(std::vector<size_t>{0, 1}).size() == n);
+        REQUIRE(S(n).orbit(std::vector<size_t>{0, 1, 2}).size() == n * (n - 1) * (n - 2) / 6);
+    }
+}
@@ -0,0 +1,191 @@
+#include <set>
+
+#include "ConeGenerator.h"
+#include "Matcher.h"
+
+#include "catch.hpp"
+
+#define CATCH_CONFIG_MAIN
+
+// number of injective maps from P to G taking edges to edges and, if v < G.size(), hitting v
+static size_t embeddings(const Graph& P, const Graph& G, size_t v, std::vector<size_t>& g, std::vector<bool>& used) {
+    size_t l = g.size();
+    if (l == P.size()) {
+        return v >= G.size() || used[v];
+    }
+    size_t q = 0;
+    for (size_t x = 0; x < G.size(); ++x) {
+        if (used[x]) {
+            continue;
+        }
+        bool B = true;
+        for (size_t i = 0; i < l; ++i) {
+            if (P.edge(i, l) && !G.edge(g[i], x)) {
+                B = false;
+            }
+        }
+        if (!B) {
+            continue;
+        }
+        g.push_back(x);
+        used[x] = true;
+        q += embeddings(P, G, v, g, used);
+        used[x] = false;
+        g.pop_back();
+    }
+    return q;
+}
+
+static size_t copies(Graph P, const Graph& G, size_t v) {
+    std::vector<size_t> g;
+    std::vector<bool> used(G.size(), false);
+    return embeddings(P, G, v, g, used) / P.aut().order();
+}
+
+TEST_CASE("existence of copies") {
+    SubgraphMatcher C4(C(4));
+    REQUIRE(C4.exists(K(2, 2)));
+    REQUIRE(C4.exists(Q(3)));
+    REQUIRE(C4.exists(K(5)));
+    REQUIRE(C4.exists(C(5)) == false);
+    REQUIRE(C4.exists(P(10)) == false);
+
+    SubgraphMatcher K3(K(3));
+    REQUIRE(K3.exists(K(3, 3)) == false);
+    REQUIRE(K3.exists(C(3) + C(7)));
+    REQUIRE(K3.exists(Q(4)) == false);
+
+    SubgraphMatcher C5(C(5));
+    REQUIRE(C5.exists(K(4, 4)) == false);
+    REQUIRE(C5.exists(K(5)));
+
+    SubgraphMatcher K23(K(2, 3));
+    REQUIRE(K23.exists(K(3, 3)));
+    REQUIRE(K23.exists(Q(3)) == false);
+
+    // a matcher for a disconnected pattern
+    SubgraphMatcher M(K(2) + K(2));
+    REQUIRE(M.exists(P(4)));
+    REQUIRE(M.exists(P(3)) == false);
+    REQUIRE(M.exists(K(1, 5)) == false);
+}
+
+TEST_CASE("copies through a vertex") {
+    std::vector<Graph> patterns = {C(4), C(5), K(3), K(2, 3), P(4), K(1, 3), K(4)};
+    std::vector<Graph> hosts = {K(6), K(3, 4), Q(3), C(4) + C(5), P(7)};
+    Graph G = C(8);
+    G.addEdge(0, 4);
+    G.addEdge(1, 5);
+    G.addEdge(2, 6);
+    hosts.push_back(G);
+
+    for (const Graph& P : patterns) {
+        SubgraphMatcher M(P);
+        for (const Graph& G : hosts) {
+            for (size_t v = 0; v < G.size(); ++v) {
+                size_t q = 0;
+                M.enumerate(G, v, [&](const std::vector<size_t>& g) {
+                    // the map must be a copy of P through v
+                    bool through = false;
+                    for (size_t i = 0; i < P.size(); ++i) {
+                        through = through || g[i] == v;
+                        for (size_t j = 0; j < P.size(); ++j) {
+                            if (P.edge(i, j)) {
+                                REQUIRE(G.edge(g[i], g[j]));
+                            }
+                        }
+                    }
+                    REQUIRE(through);
+                    ++q;
+                    return true;
+                });
+                REQUIRE(q == copies(P, G, v));
+            }
+        }
+    }
+}
+
+TEST_CASE("copies through a non-edge") {
+    std::vector<Graph> patterns = {C(4), C(6), K(3), K(2, 3), K(4), K(1, 3)};
+    std::vector<Graph> hosts = {C(7), K(3, 4), Q(3), P(6) + K(3)};
+    for (const Graph& P : patterns) {
+        SubgraphMatcher M(P);
+        for (Graph G : hosts) {
+            for (size_t u = 0; u < G.size(); ++u) {
+                for (size_t v = u + 1; v < G.size(); ++v) {
+                    if (G.edge(u, v)) {
+                        continue;
+                    }
+                    bool before = M.exists(G);
+                    bool through = M.existsThrough(G, u, v);
+                    G.addEdge(u, v);
+                    bool after = M.exists(G);
+                    G.killEdge(u, v);
+                    REQUIRE(after == (before || through));
+                    if (!before) {
+                        REQUIRE(through == after);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("forbidden sets of a new vertex") {
+    std::vector<Graph> patterns = {C(4), C(5), K(3), K(2, 3), K(4)};
+    std::vector<Graph> hosts = {C(7), K(3, 4), Q(3), P(6) + K(3)};
+    for (const Graph& P : patterns) {
+        SubgraphMatcher M(P);
+        for (const Graph& G : hosts) {
+            std::vector<std::vector<size_t>> sets = M.forbiddenSets(G);
+            std::vector<std::vector<size_t>> visited;
+            M.visitForbiddenSets(G, [&](const std::vector<size_t>& S) {
+                // joining a new vertex to S creates a copy of P
+                Graph H = G + 1;
+                for (size_t x : S) {
+                    H.addEdge(x, G.size());
+                }
+                REQUIRE(copies(P, H, G.size()) > 0);
+                visited.push_back(S);
+            });
+            std::sort(visited.begin(), visited.end());
+            visited.erase(std::unique(visited.begin(), visited.end()), visited.end());
+            REQUIRE(visited == sets);
+        }
+    }
+}
+
+TEST_CASE("cones of a new vertex") {
+    std::vector<Graph> patterns = {C(4), C(5), K(3), K(4), K(2, 3), K(1, 3)};
+    std::vector<Graph> hosts = {C(7), K(3, 4), Q(3), P(5) + K(3)};
+    ConeGenerator cg;
+    for (const Graph& P : patterns) {
+        SubgraphMatcher M(P);
+        for (const Graph& H : hosts) {
+            size_t n = H.size();
+            cg.reset(H, M);
+            for (size_t min_deg = 1; min_deg <= 3; min_deg++) {
+                std::set<std::vector<size_t>> cones;
+                cg.visitCones(min_deg, 4, [&](const std::vector<size_t>& cone) {
+                    REQUIRE(cones.insert(cone).second);
+                });
+                // all sets of min_deg to 4 vertices whose join to a new vertex makes no copy of P through it
+                std::set<std::vector<size_t>> expected;
+                for (size_t mask = 0; mask < (size_t(1) << n); mask++) {
+                    std::vector<size_t> S;
+                    Graph G = H + 1;
+                    for (size_t x = 0; x < n; x++) {
+                        if (mask >> x & 1) {
+                            S.push_back(x);
+                            G.addEdge(x, n);
+                        }
+                    }
+                    if (S.size() >= min_deg && S.size() <= 4 && copies(P, G, n) == 0) {
+                        expected.insert(S);
+                    }
+                }
+                REQUIRE(cones == expected);
+            }
+        }
+    }
+}